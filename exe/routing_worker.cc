@@ -0,0 +1,114 @@
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "transfers/storage/updater.h"
+#include "transfers/transfer/routing_shard.h"
+#include "transfers/transfer/transfer_request.h"
+#include "transfers/transfer/transfer_result.h"
+#include "transfers/types.h"
+
+#include "ppr/common/routing_graph.h"
+#include "ppr/profiles/parse_search_profile.h"
+#include "ppr/routing/search_profile.h"
+#include "ppr/serialization/reader.h"
+
+#include "utl/progress_tracker.h"
+#include "utl/verify.h"
+
+namespace fs = std::filesystem;
+namespace pr = ::ppr::routing;
+
+using namespace transfers;
+
+constexpr auto const kUsage =
+    "usage: transfers-routing-worker SHARD_DIR SHARD_INDEX PPR_GRAPH "
+    "PROFILE_NAME=PROFILE_FILE...\n";
+
+// Returns the content of the given profile file.
+std::string read_profile_file(fs::path const& path) {
+  auto in = std::ifstream{path, std::ios::binary};
+  utl::verify(in.good(), "cannot open {} for reading", path.string());
+  return std::string{std::istreambuf_iterator<char>{in},
+                     std::istreambuf_iterator<char>{}};
+}
+
+// Routes a single shard written by `storage_updater::export_routing_shards`
+// and writes the shard result next to the shard file. Shards that already
+// have a result of the same export are skipped: workers can be restarted and
+// shards dispatched again without routing finished shards twice. The given
+// profile files must contain the exported search profiles.
+int main(int argc, char const** argv) {
+  if (argc < 5) {
+    std::cerr << kUsage;
+    return 1;
+  }
+
+  auto const dir = fs::path{argv[1]};
+  auto const shard_idx = static_cast<std::size_t>(std::stoul(argv[2]));
+  auto const rg_path = fs::path{argv[3]};
+
+  // profiles: name -> ppr search profile file
+  auto name_to_profile = hash_map<std::string, pr::search_profile>{};
+  for (auto i = 4; i < argc; ++i) {
+    auto const arg = std::string_view{argv[i]};
+    auto const sep = arg.find('=');
+    if (sep == std::string_view::npos) {
+      std::cerr << kUsage;
+      return 1;
+    }
+    auto const path = fs::path{arg.substr(sep + 1)};
+    name_to_profile.emplace(
+        std::string{arg.substr(0, sep)},
+        ::ppr::profiles::parse_search_profile(read_profile_file(path)));
+  }
+
+  auto const progress_tracker =
+      utl::activate_progress_tracker("routing worker");
+  progress_tracker->status("Load Shard.");
+
+  auto const shard = read_routing_shard(routing_shard_path(dir, shard_idx));
+
+  // results of a shard with the same index of an earlier export are rerouted
+  auto const result_path = routing_shard_result_path(dir, shard_idx);
+  if (fs::exists(result_path) &&
+      is_result_of(read_routing_shard_result(result_path), shard)) {
+    std::cout << "shard " << shard_idx << " already routed\n";
+    return 0;
+  }
+
+  // the search profiles must equal the exported ones (profile parameters of
+  // the database)
+  auto const profiles = get_search_profiles(shard, name_to_profile);
+
+  progress_tracker->status("Load Routing Graph.");
+  ::ppr::routing_graph rg;
+  ::ppr::serialization::read_routing_graph(rg, rg_path.string());
+  auto const rg_config = routing_graph_config{};
+  rg.prepare_for_routing(rg_config.edge_rtree_size_,
+                         rg_config.area_rtree_size_,
+                         ::ppr::rtree_options::PREFETCH);
+
+  auto const pfs = get_platform_table(shard);
+  auto const treqs_k = get_transfer_requests_by_keys(shard);
+
+  progress_tracker->status("Route Shard.").in_high(treqs_k.size());
+  auto const tres =
+      route_multiple_requests(treqs_k, 0U, treqs_k.size(), pfs, rg, profiles,
+                              get_symmetric_profiles(shard));
+
+  auto result = routing_shard_result{};
+  result.shard_hash_ = shard.hash_;
+  for (auto const& tr : tres) {
+    result.transfer_results_.emplace_back(tr);
+  }
+  write_routing_shard_result(result_path, result);
+
+  std::cout << "shard " << shard_idx << ": " << tres.size()
+            << " transfer results\n";
+  return 0;
+}
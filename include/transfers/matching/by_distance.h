@@ -1,10 +1,14 @@
 #pragma once
 
 #include <utility>
+#include <vector>
 
 #include "transfers/matching/matcher.h"
 
+#include "geo/latlng.h"
+
 #include "nigiri/location.h"
+#include "nigiri/types.h"
 
 namespace transfers {
 
@@ -26,10 +30,25 @@ struct distance_matcher : public matcher {
   // `nigiri::location` and `platform`. The platform with the smallest distance
   // is chosen as match to the nigiri::location. Matching distances are chosen
   // from the options.
+  // If `group_locations_` is set in the options, co-located locations are
+  // grouped and each group is matched only once. The match is then applied
+  // to every location of the group that lies within the matching distance of
+  // the matched platform; the other locations are matched on their own.
   // Returns a list of all found matches.
   std::vector<matching_result> matching() override;
 
 private:
+  // Returns a list of groups of `nigiri::location`s that have not been matched
+  // yet. A location joins a group if it lies within `group_tolerance_` meters
+  // of the first location of the group; groups of its parent station are
+  // preferred (a parent station belongs to the groups of its children).
+  // Without `group_locations_` every location forms its own group.
+  std::vector<std::vector<::nigiri::location_idx_t>> group_locations() const;
+
+  // Returns whether the given platform lies within the matching distance
+  // (options) of the given coordinate.
+  bool in_matching_dist(geo::latlng const&, platform const&) const;
+
   // Matches a single `nigiri::location` and returns the result as a
   // `matching_result` struct. Returns an additional boolean value indicating
   // whether a match was found or not.
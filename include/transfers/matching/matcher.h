@@ -24,6 +24,12 @@ struct matching_data {
 struct matching_options {
   double max_matching_dist_;
   double max_bus_stop_matching_dist_;
+
+  // group_locations: match co-located nigiri locations (within
+  // `group_tolerance_` meters of the first location of a group) only once
+  // per group; locations of the same parent station are grouped first.
+  bool group_locations_{false};
+  double group_tolerance_{10.0};
 };
 
 struct matching_result {
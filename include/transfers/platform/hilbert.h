@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+#include "geo/latlng.h"
+
+namespace transfers {
+
+// Returns the position of the given coordinate on a Hilbert curve covering
+// the whole world (32 bit resolution per axis). Coordinates that are close to
+// each other on the curve are close to each other in space.
+std::uint64_t hilbert_index(geo::latlng const&);
+
+}  // namespace transfers
@@ -36,6 +36,13 @@ struct platform_index {
   std::vector<size_t> get_other_platforms_in_radius(platform const&,
                                                     double const) const;
 
+  // Returns a list of (distance, index) tuples of stored platforms in the index
+  // within a radius around the given platform. The list is sorted by distance
+  // (ascending). The given platform will not be included in the output.
+  std::vector<std::pair<double, std::size_t>>
+  get_other_platforms_in_radius_with_distance_info(platform const&,
+                                                   double const) const;
+
 private:
   // Generates a rtree using the stored platforms in the index.
   void make_point_rtree();
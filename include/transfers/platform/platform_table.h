@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "transfers/platform/platform.h"
+#include "transfers/types.h"
+
+#include "ppr/routing/input_location.h"
+
+namespace transfers {
+
+using platform_idx_t = std::uint32_t;
+
+// Table of matched platforms. Every platform is stored only once; all nigiri
+// locations matched to the same platform refer to the same table entry.
+struct platform_table {
+  // Adds the matching of the given nigiri location to the given platform.
+  // Unknown platforms are appended to the table. Already known locations are
+  // not updated.
+  void add(location_key_t const, platform const&);
+
+  // Returns the index of the platform matched to the given nigiri location.
+  platform_idx_t get_idx(location_key_t const loc_key) const {
+    return loc_to_pf_.at(loc_key);
+  }
+
+  // Returns the `i`-th platform stored in the table. `i` in [0, size() - 1].
+  platform const& get(platform_idx_t const i) const { return platforms_[i]; }
+
+  // Returns the ppr input location of the `i`-th platform. Input locations are
+  // built once when a platform is added, so that routing does not convert a
+  // platform again for every query it is part of.
+  ::ppr::routing::input_location const& get_input_location(
+      platform_idx_t const i) const {
+    return input_locs_[i];
+  }
+
+  // Returns the number of platforms stored in the table.
+  std::size_t size() const { return platforms_.size(); }
+
+  std::vector<platform> platforms_;
+  std::vector<::ppr::routing::input_location> input_locs_;
+  hash_map<location_key_t, platform_idx_t> loc_to_pf_;
+  hash_map<std::string, platform_idx_t> pf_key_to_idx_;
+};
+
+}  // namespace transfers
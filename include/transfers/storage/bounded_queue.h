@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace transfers {
+
+// Blocking FIFO queue with a fixed capacity for producer/consumer pipelines.
+// `push` blocks while the queue is full, `pop` blocks while it is empty. After
+// `close`, pushes are rejected and `pop` returns the remaining elements
+// followed by std::nullopt.
+template <typename T>
+struct bounded_queue {
+  explicit bounded_queue(std::size_t const capacity) : capacity_(capacity) {}
+
+  // Appends `el` to the queue. Returns false (and drops `el`) if the queue is
+  // closed.
+  bool push(T el) {
+    auto lock = std::unique_lock{mutex_};
+    not_full_.wait(lock,
+                   [&]() { return closed_ || elements_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    elements_.emplace_back(std::move(el));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Removes and returns the first element of the queue. Returns std::nullopt
+  // if the queue is closed and empty.
+  std::optional<T> pop() {
+    auto lock = std::unique_lock{mutex_};
+    not_empty_.wait(lock, [&]() { return closed_ || !elements_.empty(); });
+    if (elements_.empty()) {
+      return std::nullopt;
+    }
+    auto el = std::move(elements_.front());
+    elements_.pop_front();
+    not_full_.notify_one();
+    return el;
+  }
+
+  // Rejects all further pushes and wakes up all waiting threads.
+  void close() {
+    auto const lock = std::lock_guard{mutex_};
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+private:
+  std::size_t capacity_;
+  std::deque<T> elements_;
+  bool closed_{false};
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+}  // namespace transfers
@@ -3,7 +3,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -14,12 +16,57 @@
 
 #include "transfers/matching/matcher.h"
 #include "transfers/platform/platform.h"
+#include "transfers/transfer/route_cache.h"
 #include "transfers/transfer/transfer_request.h"
 #include "transfers/transfer/transfer_result.h"
 #include "transfers/types.h"
 
 namespace transfers {
 
+// Profiles of a routing run: bit `i` is set for profile key `i`.
+using profile_mask = array<std::uint64_t, 4U>;
+
+// Returns the mask of the profiles of the given requests.
+profile_mask get_profile_mask(transfer_request_by_keys_csr const&);
+
+// Returns the profiles of the given mask.
+set<profile_key_t> get_profiles(profile_mask const&);
+
+// Progress of a resumable routing phase: the results of the first
+// `n_stored_` requests of the run identified by `run_hash_` (hash of the
+// requests of the run) are stored. The requests themselves are not stored:
+// they are either the requests of the phase or are rebuilt from the stored
+// transfer requests of the profiles `profiles_` (see `get_routing_run`).
+struct routing_progress {
+  std::uint64_t run_hash_{};
+  std::uint64_t n_stored_{};
+  profile_mask profiles_{};
+};
+
+// Requests of a routing run: the results of `requests_[first_]` to
+// `requests_[requests_.size() - 1]` are not stored yet. `profiles_`: profiles
+// to rebuild the requests of the run from after an interruption.
+struct routing_run {
+  transfer_request_by_keys_csr requests_;
+  std::size_t first_{};
+  profile_mask profiles_{};
+};
+
+// Returns the routing run of a routing phase with the given `requests`.
+// `progress` is the progress of an interrupted run of the same phase (if
+// any):
+// - same requests: the run is resumed after the stored results
+// - else (e.g. the update requests are not regenerated after a restart):
+//   all stored transfer requests of the profiles of both runs are routed.
+//   They are returned by `get_stored_requests` (in key order) and contain the
+//   given requests. If this is the interrupted run (rebuilt again after
+//   another restart), it is resumed after the stored results.
+routing_run get_routing_run(
+    transfer_request_by_keys_csr const& requests,
+    std::optional<routing_progress> const& progress,
+    std::function<transfer_request_by_keys_csr(
+        set<profile_key_t> const&)> const& get_stored_requests);
+
 struct database {
   explicit database(std::filesystem::path const& db_file_path,
                     std::size_t const db_max_size);
@@ -40,10 +87,10 @@ struct database {
 
   // transfer requests
   std::vector<std::size_t> put_transfer_requests_by_keys(
-      std::vector<transfer_request_by_keys> const&);
+      transfer_request_by_keys_csr const&);
   std::vector<std::size_t> update_transfer_requests_by_keys(
-      std::vector<transfer_request_by_keys> const&);
-  std::vector<transfer_request_by_keys> get_transfer_requests_by_keys(
+      transfer_request_by_keys_csr const&);
+  transfer_request_by_keys_csr get_transfer_requests_by_keys(
       set<profile_key_t> const&);
 
   // transfer results
@@ -53,6 +100,26 @@ struct database {
       std::vector<transfer_result> const&);
   std::vector<transfer_result> get_transfer_results(set<profile_key_t> const&);
 
+  // route cache
+  std::optional<std::uint64_t> get_route_cache_fingerprint();
+  void reset_route_cache(std::uint64_t const /* rg_fingerprint */);
+  std::vector<std::optional<route_cache_entry>> get_cached_routes(
+      std::vector<std::string> const&);
+  void put_cached_routes(
+      std::vector<std::pair<std::string, route_cache_entry>> const&);
+
+  // profile hashes
+  hash_map<profile_key_t, std::uint64_t> get_profile_hashes();
+  void put_profile_hashes(hash_map<profile_key_t, std::uint64_t> const&);
+  void delete_transfers_of_profiles(set<profile_key_t> const&);
+
+  // routing progress (stored per routing phase)
+  std::optional<routing_progress> get_routing_progress(
+      std::uint8_t const /* phase */);
+  void put_routing_progress(std::uint8_t const /* phase */,
+                            routing_progress const&);
+  void delete_routing_progress(std::uint8_t const /* phase */);
+
 private:
   static lmdb::txn::dbi profiles_dbi(
       lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
@@ -64,6 +131,12 @@ private:
       lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
   static lmdb::txn::dbi transfers_dbi(
       lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
+  static lmdb::txn::dbi routecache_dbi(
+      lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
+  static lmdb::txn::dbi meta_dbi(
+      lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
+  static lmdb::txn::dbi profilehashes_dbi(
+      lmdb::txn&, lmdb::dbi_flags flags = lmdb::dbi_flags::NONE);
 
   void init();
 
@@ -1,15 +1,21 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "transfers/matching/matcher.h"
 #include "transfers/platform/platform.h"
 #include "transfers/platform/platform_index.h"
+#include "transfers/platform/platform_table.h"
 #include "transfers/storage/database.h"
 #include "transfers/storage/to_nigiri.h"
+#include "transfers/transfer/route_cache.h"
 #include "transfers/transfer/transfer_request.h"
 #include "transfers/transfer/transfer_result.h"
 #include "transfers/types.h"
@@ -48,13 +54,21 @@ struct storage {
   // platforms. Combines old and new matchings.
   hash_map<location_key_t, platform> get_all_matchings();
 
+  // Returns a `platform_table` of all known matchings of nigiri locations to
+  // osm extracted platforms. Combines old and new matchings. Every matched
+  // platform is stored only once.
+  platform_table get_platform_table();
+
   // Returns whether the storage contains a list of `transfer_request_by_keys`
   // for the corresponding `data_request_type`.
   bool has_transfer_requests_by_keys(data_request_type const);
 
   // Returns for the given `data_request_type` a list of
   // `transfer_request_by_keys` which are stored in the storage.
-  std::vector<transfer_request_by_keys> get_transfer_requests_by_keys(
+  // The returned reference is valid until the transfer requests of the
+  // storage are modified. The combined list (`kFull`) is built once and reused
+  // until then.
+  transfer_request_by_keys_csr const& get_transfer_requests_by_keys(
       data_request_type const);
 
   // Returns a `treq_k_generation_data` struct containing all the data used
@@ -83,8 +97,7 @@ struct storage {
   // (described by the given transfer_request_keys is added to the
   // `update_state_` state struct.
   // Update merges the old transfer request keys with the new one.
-  void add_new_transfer_requests_by_keys(
-      std::vector<transfer_request_by_keys> const&);
+  void add_new_transfer_requests_by_keys(transfer_request_by_keys_csr const&);
 
   // Adds new transfer results to the database. Previously unknown transfer
   // results are added to the `update_state_` state struct. Previously known
@@ -93,6 +106,58 @@ struct storage {
   // Update merges the old transfer result with the new one.
   void add_new_transfer_results(std::vector<transfer_result> const&);
 
+  // Same as `add_new_transfer_results`, but keeps the transfer results already
+  // added to the `update_state_` state struct (e.g. by previous batches of
+  // the same routing phase).
+  void append_new_transfer_results(std::vector<transfer_result> const&);
+
+  // Prepares the persistent route cache for the routing graph with the given
+  // fingerprint. Cached routes computed with another routing graph are
+  // deleted.
+  void init_route_cache(std::uint64_t const /* rg_fingerprint */);
+
+  // Returns the cached route for every given route cache key (empty if the
+  // key is not cached).
+  std::vector<std::optional<route_cache_entry>> get_cached_routes(
+      std::vector<std::string> const&);
+
+  // Adds the given routes to the persistent route cache. Existing entries
+  // with the same key are overwritten.
+  void add_cached_routes(
+      std::vector<std::pair<std::string, route_cache_entry>> const&);
+
+  // Compares the parameter hash (see `hash_search_profile`) of every profile
+  // in `profile_key_to_search_profile_` with the hash stored in the database.
+  // Transfer requests and transfer results of profiles whose parameters
+  // changed are deleted from the database and from the old state. Profiles
+  // without a stored hash are considered unchanged. Returns the changed
+  // profiles. The stored hashes are not modified (see `store_profile_hashes`).
+  // Prerequisites:
+  // - used_profiles_ and profile_key_to_search_profile_ must already be set.
+  set<profile_key_t> invalidate_changed_profiles();
+
+  // Stores the parameter hash of every profile in
+  // `profile_key_to_search_profile_`. Must only be called after the transfers
+  // of the changed profiles are routed: until then, an interrupted update
+  // detects the changed profiles again.
+  void store_profile_hashes();
+
+  // Returns the routing run of the given routing phase with the given
+  // requests (see `get_routing_run`). Only the progress of a new run is
+  // stored: the requests of an interrupted run are rebuilt from the stored
+  // transfer requests.
+  routing_run start_routing_run(data_request_type const,
+                                transfer_request_by_keys_csr const&);
+
+  // Returns whether an interrupted run of the given routing phase is stored.
+  bool has_interrupted_routing_run(data_request_type const);
+
+  // Stores the progress of the current run of the given routing phase.
+  void set_routing_progress(data_request_type const, routing_progress const&);
+
+  // Deletes the stored routing run (routing phase completed).
+  void reset_routing_progress(data_request_type const);
+
   ::nigiri::timetable& tt_;
 
   hash_map<string_t, profile_key_t> profile_name_to_profile_key_;
@@ -101,6 +166,10 @@ struct storage {
       profile_key_to_search_profile_;
   set<profile_key_t> used_profiles_;
 
+  // profiles without direction dependent costs or restrictions: A -> B and
+  // B -> A are routed only once (see `prune_symmetric_pairs`)
+  set<profile_key_t> symmetric_profiles_;
+
 private:
   // Loads all transfers data from the database and stores it in the
   // `old_state_` state struct.
@@ -130,10 +199,15 @@ private:
 
     // mapping matched nloc to pf
     hash_map<location_key_t, platform> matches_;
-    std::vector<transfer_request_by_keys> transfer_requests_by_keys_;
+    transfer_request_by_keys_csr transfer_requests_by_keys_;
     std::vector<transfer_result> transfer_results_;
   } old_state_, update_state_;
 
+  // old and update `transfer_request_by_keys` (data_request_type::kFull);
+  // rebuilt only after the old or update requests changed
+  transfer_request_by_keys_csr full_transfer_requests_by_keys_;
+  bool full_transfer_requests_by_keys_valid_{false};
+
   database db_;
 };
 
@@ -1,9 +1,21 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "transfers/storage/bounded_queue.h"
 #include "transfers/storage/storage.h"
+#include "transfers/transfer/route_cache.h"
+#include "transfers/transfer/routing_region.h"
+#include "transfers/transfer/thread_placement.h"
+#include "transfers/transfer/transfer_result.h"
+
+#include "ppr/common/routing_graph.h"
 
 #include "nigiri/timetable.h"
 
@@ -11,13 +23,27 @@
 
 namespace transfers {
 
-enum class first_update { kNoUpdate, kProfiles, kTimetable, kOSM };
+// kChangedProfiles: only profiles whose search parameters changed since the
+// last routed update (see `storage::invalidate_changed_profiles`) are
+// invalidated and get new transfer requests.
+enum class first_update {
+  kNoUpdate,
+  kProfiles,
+  kTimetable,
+  kOSM,
+  kChangedProfiles
+};
 enum class routing_type { kNoRouting, kPartialRouting, kFullRouting };
 
 struct routing_graph_config {
   std::size_t edge_rtree_size_{1024UL * 1024 * 1024 * 3};
   std::size_t area_rtree_size_{1024UL * 1024 * 1024};
   bool lock_rtree_{false};
+
+  // pre-tiled routing graphs: if a tile contains all platforms of a routing
+  // phase (buffered by the maximum walking distance of the profiles), the
+  // smallest such tile is loaded instead of the complete routing graph.
+  std::vector<routing_graph_tile> tiles_;
 };
 
 struct storage_updater_config {
@@ -33,9 +59,29 @@ struct storage_updater_config {
   // matching config
   double max_matching_dist_{400};
   double max_bus_stop_matching_dist_{120};
+  bool group_locations_{false};
+  double group_tolerance_{10.0};
 
   // routing_graph config
   routing_graph_config rg_config_;
+
+  // routing config
+  // use_route_cache_: reuse routes of (start, target, profile) pairs stored
+  // in the database if neither the routing graph nor the profile parameters
+  // nor the platform coordinates changed.
+  bool use_route_cache_{false};
+  // routing_batch_size_: number of transfer requests routed and stored per
+  // checkpoint. An interrupted routing phase resumes after the last stored
+  // batch (the requests of the run are stored with the progress).
+  std::size_t routing_batch_size_{100'000};
+  // routing_threads_: size and placement of the routing thread pool.
+  routing_thread_config routing_threads_;
+
+  // routing instrumentation (disabled if empty): every routing phase writes
+  // a latency histogram per profile and its `routing_stats_n_slowest_`
+  // slowest routing queries to `routing_stats_dir_`/routing_stats_{phase}.json
+  std::filesystem::path routing_stats_dir_;
+  std::size_t routing_stats_n_slowest_{100};
 };
 
 struct storage_updater {
@@ -48,7 +94,14 @@ struct storage_updater {
         nigiri_dump_path_(config.nigiri_dump_path_),
         max_matching_dist_(config.max_matching_dist_),
         max_bus_stop_matching_dist_(config.max_bus_stop_matching_dist_),
-        rg_config_(config.rg_config_) {
+        group_locations_(config.group_locations_),
+        group_tolerance_(config.group_tolerance_),
+        rg_config_(config.rg_config_),
+        use_route_cache_(config.use_route_cache_),
+        routing_batch_size_(config.routing_batch_size_),
+        routing_threads_(config.routing_threads_),
+        routing_stats_dir_(config.routing_stats_dir_),
+        routing_stats_n_slowest_(config.routing_stats_n_slowest_) {
     storage_.initialize();
   }
   storage_updater(std::filesystem::path const& db_file_path,
@@ -72,6 +125,30 @@ struct storage_updater {
   // application of the transfer calculation.
   void partial_update(first_update const, routing_type const);
 
+  // Sharded routing (e.g. on multiple machines with a shared file system):
+  // 1st: `export_routing_shards` writes the transfer requests of the given
+  //      `data_request_type` into `n_shards` spatial shard files in `dir`.
+  // 2nd: every shard is routed independently by `transfers-routing-worker`.
+  // 3rd: `import_routing_shards` stores the results of all shards and
+  //      updates the timetable.
+  //
+  // Existing shard files and shard results in `dir` are removed. Returns the
+  // number of written shard files.
+  std::size_t export_routing_shards(data_request_type const,
+                                    std::filesystem::path const& dir,
+                                    std::size_t const n_shards);
+
+  // Imports the results of the `n_shards` routed shards in `dir`. Verifies
+  // against the manifest of the last export that `n_shards` shards were
+  // exported and that every shard has a result of this export (results are
+  // read twice: nothing is stored if a result is missing or stale).
+  void import_routing_shards(std::filesystem::path const& dir,
+                             std::size_t const n_shards);
+
+  // Frees the routing graph kept by the updater. The graph is loaded again by
+  // the next routing phase.
+  void release_routing_graph();
+
   storage storage_;
 
 private:
@@ -87,21 +164,75 @@ private:
   // and stores them in the database and in the storage.
   void generate_and_store_transfer_requests(bool const old_to_old = false);
 
+  // Invalidates the transfers of all profiles whose search parameters changed
+  // and generates their transfer requests (incl. old to old) again. Stored
+  // transfer requests and results of unchanged profiles are kept.
+  void regenerate_transfer_requests_of_changed_profiles();
+
   // Generates transfer results based on transfer requests (stored in the
   // storage) using ppr and stores them in the database and in the storage.
+  // Requests are routed and stored in batches of `routing_batch_size_`; the
+  // progress is stored after every batch, so that an interrupted run of the
+  // same routing phase skips the already stored batches.
   //
   // data_request_type: determines the data to be considered.
   void generate_and_store_transfer_results(data_request_type const);
 
+  // Returns the routing graph to be loaded for the given transfer requests:
+  // the already loaded graph if it covers the (buffered) region of the
+  // requests, else the smallest configured tile that contains the region, or
+  // the complete routing graph.
+  std::filesystem::path get_routing_graph_path(
+      transfer_request_by_keys_csr const&, platform_table const&);
+
+  // Returns the routing graph stored at the given path. The graph is loaded
+  // and prepared for routing on first use and kept for all further routing
+  // phases (and updates) of this updater; loading another path replaces it.
+  ::ppr::routing_graph const& get_routing_graph(std::filesystem::path const&);
+
+  // Routing results of a batch of transfer requests, handed from routing to
+  // the writer thread.
+  struct result_batch {
+    std::vector<transfer_result> transfer_results_;
+    std::vector<std::pair<std::string, route_cache_entry>> cached_routes_;
+
+    // all requests in [0, n_stored_) are stored after this batch
+    std::size_t n_stored_;
+
+    // first batch of the routing phase: replaces the previous update state
+    bool first_;
+  };
+
+  // Writer thread of `generate_and_store_transfer_results`: stores the
+  // batches of the given queue in order and records the routing progress
+  // (of the run given by `progress`) after every batch. Returns once the
+  // queue is closed and drained.
+  void store_result_batches(bounded_queue<result_batch>&,
+                            data_request_type const,
+                            routing_progress progress);
+
   std::filesystem::path osm_path_;
   std::filesystem::path ppr_rg_path_;
   std::filesystem::path nigiri_dump_path_;
 
   double max_matching_dist_{400};
   double max_bus_stop_matching_dist_{120};
+  bool group_locations_{false};
+  double group_tolerance_{10.0};
 
   routing_graph_config rg_config_;
 
+  // lazily loaded routing graph (see `get_routing_graph`)
+  std::unique_ptr<::ppr::routing_graph> rg_;
+  std::filesystem::path rg_path_;
+
+  bool use_route_cache_{false};
+  std::size_t routing_batch_size_{100'000};
+  routing_thread_config routing_threads_;
+
+  std::filesystem::path routing_stats_dir_;
+  std::size_t routing_stats_n_slowest_{100};
+
   utl::progress_tracker_ptr progress_tracker_{
       utl::get_active_progress_tracker()};
 };
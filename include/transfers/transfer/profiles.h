@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "transfers/types.h"
+
+#include "ppr/routing/search_profile.h"
+
+namespace transfers {
+
+// Returns the maximum beeline distance in meters that can be covered using the
+// given search profile.
+// Equivalent to: walking_speed_ * duration_limit_
+double get_max_distance(::ppr::routing::search_profile const&);
+
+// Returns a hash over all parameters of the given search profile. Search
+// profiles with equal parameters have equal hashes (independent of the
+// profile name or key).
+std::uint64_t hash_search_profile(::ppr::routing::search_profile const&);
+
+// Returns the canonical profile of every given profile: profiles with equal
+// search parameters are mapped to the smallest profile key among them, so
+// that they can be routed as one profile. `hash_search_profile` only groups
+// the candidates; the parameters are compared field by field.
+hash_map<profile_key_t, profile_key_t> get_canonical_profiles(
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&);
+
+// Returns the canonical profiles (see `get_canonical_profiles`) that are
+// symmetric: a canonical profile is symmetric only if all profiles mapped to
+// it are contained in `symmetric`. Profiles without an entry in `canonical`
+// are their own canonical profile.
+set<profile_key_t> get_symmetric_canonical_profiles(
+    hash_map<profile_key_t, profile_key_t> const& /* canonical */,
+    set<profile_key_t> const& /* symmetric */);
+
+}  // namespace transfers
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "transfers/platform/platform.h"
+#include "transfers/platform/platform_table.h"
+#include "transfers/transfer/transfer_request.h"
+#include "transfers/transfer/transfer_result.h"
+#include "transfers/types.h"
+
+#include "geo/latlng.h"
+
+namespace transfers {
+
+// Cached routing result of a single (start platform, target platform,
+// profile) pair. Unreachable pairs are cached as well (`reached_ == false`).
+struct route_cache_entry {
+  // coordinates of the start and target platform used for routing: an entry
+  // of a platform that moved since is not used
+  geo::latlng from_;
+  geo::latlng to_;
+
+  bool reached_{false};
+  transfer_info info_;
+};
+
+// Returns the route cache key of a (start platform, target platform, profile)
+// triple. The profile is identified by the hash of its parameters (see
+// `hash_search_profile`).
+std::string route_cache_key(platform const& /* from */,
+                            platform const& /* to */,
+                            std::uint64_t const /* profile_hash */);
+
+// Returns a fingerprint (file size and last modification time) of the given
+// routing graph file. Cached routes are only valid for the routing graph they
+// were computed with.
+std::uint64_t routing_graph_fingerprint(std::filesystem::path const&);
+
+// Returns the route cache keys of all (start, target, profile) pairs of the
+// given `transfer_request`s in request and target order.
+std::vector<std::string> get_route_cache_keys(
+    std::vector<transfer_request> const&, platform_table const&,
+    hash_map<profile_key_t, std::uint64_t> const& /* profile_hashes */);
+
+struct route_cache_split {
+  // `transfer_result`s built from the cached routes (only requests with at
+  // least one cached and reachable target)
+  std::vector<transfer_result> cached_;
+
+  // `transfer_request`s reduced to their targets without a (valid) cached
+  // route (only requests with at least one such target)
+  std::vector<transfer_request> uncached_;
+};
+
+// Splits the given `transfer_request`s into cached and uncached routes.
+// `cached` holds one entry per key returned by `get_route_cache_keys` for the
+// given requests (empty if the key is not cached).
+route_cache_split split_cached_routes(
+    std::vector<transfer_request> const&, platform_table const&,
+    std::vector<std::optional<route_cache_entry>> const& /* cached */);
+
+// Returns the route cache entries of all pairs of the given (routed)
+// `transfer_request`s: targets contained in the corresponding
+// `transfer_result` are cached with their `transfer_info`, all other targets
+// as unreachable.
+std::vector<std::pair<std::string, route_cache_entry>> to_route_cache_entries(
+    std::vector<transfer_request> const&, std::vector<transfer_result> const&,
+    platform_table const&,
+    hash_map<profile_key_t, std::uint64_t> const& /* profile_hashes */);
+
+// Merges all `transfer_result`s with the same key (from location and profile)
+// into a single `transfer_result`. The order of first occurrence is kept.
+std::vector<transfer_result> merge_by_key(std::vector<transfer_result> const&);
+
+}  // namespace transfers
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "transfers/platform/platform_table.h"
+#include "transfers/transfer/transfer_request.h"
+
+#include "geo/box.h"
+
+namespace transfers {
+
+// Pre-tiled part of the routing graph: a routing graph file that contains
+// the complete street network within `bbox_`.
+struct routing_graph_tile {
+  std::filesystem::path path_;
+  geo::box bbox_;
+};
+
+// Returns the bounding box of the start and target platforms of all given
+// transfer requests.
+geo::box get_bounding_box(transfer_request_by_keys_csr const&,
+                          platform_table const&);
+
+// Returns the given box extended by `meters` in every direction.
+geo::box buffer_box(geo::box const&, double const meters);
+
+// Returns whether `outer` completely contains `inner`.
+bool contains(geo::box const& outer, geo::box const& inner);
+
+// Returns the path of the smallest routing graph tile that contains the given
+// region. Returns `full_graph` if no tile contains the region.
+std::filesystem::path select_routing_graph(
+    std::vector<routing_graph_tile> const&, geo::box const& region,
+    std::filesystem::path const& full_graph);
+
+}  // namespace transfers
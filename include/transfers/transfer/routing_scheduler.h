@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "transfers/transfer/thread_placement.h"
+
+namespace transfers {
+
+// Work stealing scheduler for routing tasks.
+// Every worker owns a contiguous range of `order_` (task indices). A worker
+// processes its own range from the front; idle workers steal tasks from the
+// back of the ranges of other workers. Ranges are updated lock-free.
+struct work_stealing_scheduler {
+  // Creates a scheduler for the given task order. `range_sizes[w]` is the
+  // number of tasks initially assigned to worker `w`; the ranges follow each
+  // other in `order`.
+  // Requirement: sum(range_sizes) == order.size() < 2^32
+  work_stealing_scheduler(std::vector<std::size_t> order,
+                          std::vector<std::size_t> const& range_sizes);
+
+  // Returns the number of workers.
+  std::size_t n_workers() const { return ranges_.size(); }
+
+  // Places worker `w` on thread `w` of the given placement: the worker thread
+  // is pinned to its CPU (if given) and steals from workers on the same NUMA
+  // node before stealing from other nodes.
+  // Requirement: placement is empty or placement.n_threads() >= n_workers()
+  void set_placement(thread_placement const&);
+
+  // Calls `fn(worker_idx, task_idx)` once for every task using one thread per
+  // worker. `worker_idx` is in [0, n_workers()) and can be used to access
+  // per-worker state. Blocks until all tasks have been processed. Rethrows the
+  // first exception thrown by `fn` after all threads have finished.
+  void run(std::function<void(std::size_t, std::size_t)> const& fn);
+
+private:
+  // Takes the next task from the front of the range of the given worker.
+  std::optional<std::size_t> pop(std::size_t const worker);
+
+  // Steals a task from the back of the range of another worker (in the order
+  // of `victims_[thief]`).
+  std::optional<std::size_t> steal(std::size_t const thief);
+
+  // [begin, end) positions in `order_`, packed: begin (low) | end (high)
+  struct alignas(64) range {
+    std::atomic<std::uint64_t> bounds_;
+  };
+
+  std::vector<std::size_t> order_;
+  std::vector<range> ranges_;
+
+  // steal order of every worker
+  std::vector<std::vector<std::size_t>> victims_;
+
+  // CPUs of every worker (empty: workers are not bound to CPUs)
+  std::vector<std::vector<unsigned>> cpus_;
+};
+
+// Returns a scheduler that assigns contiguous chunks of spatially sorted tasks
+// to `n_workers` workers. Tasks are sorted by their `spatial_keys` (e.g.
+// Hilbert index of the start coordinate) and split into chunks of roughly
+// equal total cost, so that the searches of a worker touch nearby parts of
+// the routing graph. Within a chunk, tasks are ordered by cost (descending,
+// ties in curve order): every worker starts with its most expensive task and
+// the cheap tasks remain for the end (and for stealing). Stolen tasks are
+// taken from the end of a chunk and therefore remain spatially close as well.
+// Requirement: spatial_keys.size() == costs.size()
+work_stealing_scheduler make_spatial_scheduler(
+    std::vector<std::uint64_t> const& spatial_keys,
+    std::vector<double> const& costs, std::size_t const n_workers);
+
+}  // namespace transfers
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "transfers/platform/platform.h"
+#include "transfers/platform/platform_table.h"
+#include "transfers/transfer/transfer_request.h"
+#include "transfers/transfer/transfer_result.h"
+#include "transfers/types.h"
+
+#include "ppr/routing/search_profile.h"
+
+namespace transfers {
+
+// Self-contained routing input of a shard (see `make_routing_shards`): the
+// transfer requests (key form, CSR layout) and the platforms matched to all
+// locations referenced by the requests.
+struct routing_shard {
+  // transfer requests
+  vector<location_key_t> from_locs_;
+  vector<profile_key_t> profiles_;
+  vector<std::uint64_t> offsets_;
+  vector<location_key_t> to_locs_;
+
+  // matched platform of every referenced location
+  vector<location_key_t> locs_;
+  vector<platform> pfs_;
+
+  // names of the used profiles (to look up the search profiles) and the
+  // `hash_search_profile` values of their exported search profiles
+  vector<profile_key_t> profile_keys_;
+  vector<string_t> profile_names_;
+  vector<std::uint64_t> profile_hashes_;
+
+  // used profiles that are symmetric (see `route_multiple_requests`)
+  vector<profile_key_t> symmetric_profiles_;
+
+  // hash over the content of the shard (identifies the exported shard)
+  std::uint64_t hash_{};
+};
+
+// Hashes (`routing_shard::hash_`) of all shards of an export; written next to
+// the shard files.
+struct routing_shard_manifest {
+  vector<std::uint64_t> shard_hashes_;
+};
+
+// Routing output of a shard.
+struct routing_shard_result {
+  vector<transfer_result> transfer_results_;
+
+  // `routing_shard::hash_` of the routed shard
+  std::uint64_t shard_hash_{};
+};
+
+// Splits the given transfer requests into (at most) `n_shards` spatial shards:
+// requests are sorted by the Hilbert index of their start location and cut
+// into contiguous ranges with roughly the same number of targets.
+// Every shard carries the hashes of its search profiles and its symmetric
+// profiles, so that workers route with the exported profile parameters.
+// Requirement: all locations of the requests are contained in `matches`, all
+// profiles of the requests are contained in `profile_names` and `profiles`.
+std::vector<routing_shard> make_routing_shards(
+    transfer_request_by_keys_csr const&,
+    hash_map<location_key_t, platform> const& /* matches */,
+    hash_map<profile_key_t, string_t> const& /* profile_names */,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&
+    /* profiles */,
+    set<profile_key_t> const& /* symmetric */, std::size_t const n_shards);
+
+// Returns the manifest of the given shards.
+routing_shard_manifest make_routing_shard_manifest(
+    std::vector<routing_shard> const&);
+
+// Returns the search profiles of the given shard: `profile_files` maps the
+// profile names to the search profiles parsed by the worker. Verifies that
+// every search profile equals the exported one (`hash_search_profile`).
+hash_map<profile_key_t, ::ppr::routing::search_profile> get_search_profiles(
+    routing_shard const&,
+    hash_map<std::string, ::ppr::routing::search_profile> const&
+    /* name_to_profile */);
+
+// Returns the symmetric profiles of the given shard.
+set<profile_key_t> get_symmetric_profiles(routing_shard const&);
+
+// Returns the transfer requests of the given shard.
+transfer_request_by_keys_csr get_transfer_requests_by_keys(
+    routing_shard const&);
+
+// Returns the `platform_table` of all locations of the given shard.
+platform_table get_platform_table(routing_shard const&);
+
+// Returns whether the given result belongs to the given shard (and not to a
+// shard with the same index of an earlier export).
+bool is_result_of(routing_shard_result const&, routing_shard const&);
+
+// Removes all shard files, shard result files, temporary shard result files
+// and the manifest from `dir`.
+void remove_routing_shard_files(std::filesystem::path const& dir);
+
+// Returns the path of the `i`-th shard file / shard result file in `dir`.
+std::filesystem::path routing_shard_path(std::filesystem::path const& dir,
+                                         std::size_t const i);
+std::filesystem::path routing_shard_result_path(
+    std::filesystem::path const& dir, std::size_t const i);
+
+// Returns the path of the manifest in `dir`.
+std::filesystem::path routing_shard_manifest_path(
+    std::filesystem::path const& dir);
+
+// Writes / reads a manifest file.
+void write_routing_shard_manifest(std::filesystem::path const&,
+                                  routing_shard_manifest const&);
+routing_shard_manifest read_routing_shard_manifest(
+    std::filesystem::path const&);
+
+// Writes / reads a shard file.
+void write_routing_shard(std::filesystem::path const&, routing_shard const&);
+routing_shard read_routing_shard(std::filesystem::path const&);
+
+// Writes / reads a shard result file. The result file is written to a
+// temporary file first and renamed afterwards: an existing result file is
+// always complete.
+void write_routing_shard_result(std::filesystem::path const&,
+                                routing_shard_result const&);
+routing_shard_result read_routing_shard_result(std::filesystem::path const&);
+
+}  // namespace transfers
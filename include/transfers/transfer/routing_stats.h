@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "transfers/platform/platform_table.h"
+#include "transfers/types.h"
+
+namespace transfers {
+
+// Measurement of a single routing query: one start platform, one profile and
+// all targets of the requests of this start platform and profile. `profile_`
+// is the canonical profile (see `get_canonical_profiles`): the query is shared
+// by all profiles with the same search parameters.
+struct routing_query_stats {
+  platform_idx_t start_;
+  profile_key_t profile_;
+
+  // wall time of the search in microseconds
+  std::uint64_t duration_us_;
+
+  std::uint32_t n_targets_;
+  std::uint32_t n_reached_;
+};
+
+// Number of latency histogram buckets: bucket 0 counts queries below 1 ms,
+// bucket `i` counts queries in [2^(i-1), 2^i) ms, the last bucket counts all
+// slower queries.
+constexpr auto const kLatencyBuckets = std::size_t{18U};
+
+// Latency summary of the routing queries of a single canonical profile.
+struct profile_latency {
+  profile_key_t profile_;
+
+  // profiles routed by these queries: the canonical profile and all profiles
+  // mapped to it (sorted)
+  std::vector<profile_key_t> aliases_;
+
+  std::uint64_t n_queries_{0U};
+  std::uint64_t n_targets_{0U};
+  std::uint64_t n_reached_{0U};
+  std::uint64_t total_us_{0U};
+  std::uint64_t max_us_{0U};
+  std::array<std::uint64_t, kLatencyBuckets> histogram_{};
+};
+
+// Summary of the routing queries of a routing phase.
+struct routing_stats_summary {
+  // sorted by profile key
+  std::vector<profile_latency> profiles_;
+
+  // slowest queries, sorted by descending duration
+  std::vector<routing_query_stats> slowest_;
+};
+
+// Returns the histogram bucket of the given query duration.
+std::size_t get_latency_bucket(std::uint64_t const duration_us);
+
+// Summarizes the given query measurements: latency histogram per canonical
+// profile and the `n_slowest` slowest queries. The aliases of the profiles
+// are taken from `canonical` (see `get_canonical_profiles`; profiles without
+// an entry are their own canonical profile).
+routing_stats_summary summarize_routing_stats(
+    std::vector<routing_query_stats> const&, std::size_t const n_slowest,
+    hash_map<profile_key_t, profile_key_t> const& /* canonical */ = {});
+
+// Writes the given summary as JSON to the given file. Start platforms are
+// written as platform keys (looked up in the given `platform_table`), profiles
+// as profile names. Every profile summary lists the names of its aliases.
+void write_routing_stats(
+    std::filesystem::path const&, routing_stats_summary const&,
+    platform_table const&,
+    hash_map<profile_key_t, string_t> const& /* profile_names */);
+
+}  // namespace transfers
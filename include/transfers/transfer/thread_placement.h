@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace transfers {
+
+// Configuration of the routing threads.
+struct routing_thread_config {
+  // number of routing threads (0: one thread per available CPU)
+  std::size_t n_threads_{0U};
+
+  // pin every routing thread to its own CPU (CPUs are used node by node)
+  bool pin_threads_{false};
+
+  // idle routing threads steal work from threads on the same NUMA node first;
+  // threads that are not pinned are bound to the CPUs of their node
+  bool numa_aware_{false};
+};
+
+// Available CPUs grouped by NUMA node.
+struct cpu_topology {
+  // Returns the number of CPUs over all nodes.
+  std::size_t n_cpus() const;
+
+  std::vector<std::vector<unsigned>> nodes_;
+};
+
+// Placement of the routing threads: thread `i` runs on NUMA node `nodes_[i]`
+// and on the CPUs `cpus_[i]` (pinned: one CPU, NUMA aware: all CPUs of the
+// node).
+struct thread_placement {
+  // Returns the number of threads. Default: one thread per hardware thread.
+  std::size_t n_threads() const;
+
+  // empty: default number of threads, all on node 0
+  std::vector<std::size_t> nodes_;
+
+  // empty: threads are not bound to CPUs
+  std::vector<std::vector<unsigned>> cpus_;
+};
+
+// Parses a Linux CPU list (e.g. "0-3,8,10-11").
+std::vector<unsigned> parse_cpu_list(std::string_view);
+
+// Returns the CPUs available to this process grouped by NUMA node. Reads the
+// node CPU lists from sysfs on Linux; falls back to a single node with one
+// CPU per hardware thread.
+cpu_topology get_cpu_topology();
+
+// Returns the placement of the routing threads for the given configuration.
+// Threads are assigned to the CPUs node by node, so that a capped pool is
+// kept on as few nodes as possible.
+thread_placement make_thread_placement(routing_thread_config const&,
+                                       cpu_topology const&);
+
+// Binds the calling thread to the given CPUs. Returns whether binding is
+// supported and succeeded.
+bool bind_current_thread(std::vector<unsigned> const& cpus);
+
+}  // namespace transfers
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <ostream>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "transfers/platform/platform.h"
 #include "transfers/platform/platform_index.h"
+#include "transfers/platform/platform_table.h"
 #include "transfers/types.h"
 
 #include "ppr/routing/search_profile.h"
@@ -26,6 +31,92 @@ struct transfer_request_by_keys {
   profile_key_t profile_;
 };
 
+// Non-owning view of a single `transfer_request_by_keys` stored in a
+// `transfer_request_by_keys_csr` container.
+struct transfer_request_by_keys_view {
+  // Returns a short and unique `transfer_request_by_keys` representation that
+  // can be used as a database id/key. Equals `transfer_request_by_keys::key`.
+  std::string key() const;
+
+  // Returns an owning `transfer_request_by_keys` copy of the viewed request.
+  transfer_request_by_keys to_transfer_request_by_keys() const;
+
+  location_key_t from_loc_;
+  std::span<location_key_t const> to_locs_;
+  profile_key_t profile_;
+};
+
+// Compact (CSR) representation of a list of `transfer_request_by_keys`.
+// The targets of all requests are stored in one flat array: the targets of the
+// i-th request are `to_locs_[offsets_[i]]` to `to_locs_[offsets_[i + 1] - 1]`.
+struct transfer_request_by_keys_csr {
+  struct const_iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = transfer_request_by_keys_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = transfer_request_by_keys_view;
+
+    transfer_request_by_keys_view operator*() const { return (*csr_)[i_]; }
+    const_iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      auto const copy = *this;
+      ++i_;
+      return copy;
+    }
+    bool operator==(const_iterator const&) const = default;
+
+    transfer_request_by_keys_csr const* csr_;
+    std::size_t i_;
+  };
+
+  // Returns the number of stored requests.
+  std::size_t size() const { return from_locs_.size(); }
+
+  // Returns whether the container stores no request.
+  bool empty() const { return from_locs_.empty(); }
+
+  // Returns a view of the `i`-th request. `i` in [0, size() - 1].
+  transfer_request_by_keys_view operator[](std::size_t const i) const {
+    return {from_locs_[i],
+            std::span<location_key_t const>{to_locs_.data() + offsets_[i],
+                                            offsets_[i + 1] - offsets_[i]},
+            profiles_[i]};
+  }
+
+  const_iterator begin() const { return {this, 0U}; }
+  const_iterator end() const { return {this, size()}; }
+
+  // Appends a new request to the container.
+  void emplace_back(location_key_t const from_loc,
+                    std::span<location_key_t const> to_locs,
+                    profile_key_t const profile);
+  void emplace_back(transfer_request_by_keys_view const&);
+  void emplace_back(transfer_request_by_keys const&);
+
+  // Appends all requests of `other` to the container.
+  void append(transfer_request_by_keys_csr const& other);
+
+  // Reserves memory for `n_requests` requests with `n_to_locs` targets in
+  // total.
+  void reserve(std::size_t const n_requests, std::size_t const n_to_locs);
+
+  // Removes all stored requests.
+  void clear();
+
+  // Returns a hash over all stored requests (depends on the request order).
+  std::uint64_t hash() const;
+
+  std::vector<location_key_t> from_locs_;
+  std::vector<profile_key_t> profiles_;
+  std::vector<std::size_t> offsets_{0U};
+  std::vector<location_key_t> to_locs_;
+};
+
 struct transfer_request {
   friend std::ostream& operator<<(std::ostream&, transfer_request const&);
 
@@ -33,10 +124,11 @@ struct transfer_request {
   // used as a database id/key.
   std::string key() const;
 
-  platform transfer_start_;
+  // platforms are referenced by their index in a `platform_table`
+  platform_idx_t transfer_start_;
   location from_loc_;
 
-  std::vector<platform> transfer_targets_;
+  std::vector<platform_idx_t> transfer_targets_;
   std::vector<location> to_locs_;
 
   profile_key_t profile_;
@@ -61,12 +153,16 @@ struct transfer_request_options {
 
 // Creates a list of `transfer_request` struct from the given list of
 // `transfer_request_keys` struct and returns it. Keys are replaced by the
-// matched platform.
+// index of the matched platform in the given `platform_table`.
 // Requirement: X must only contain nigiri locations that have
 // been successfully matched to an OSM platform.
 std::vector<transfer_request> to_transfer_requests(
-    std::vector<transfer_request_by_keys> const&,
-    hash_map<location_key_t, platform> const&);
+    transfer_request_by_keys_csr const&, platform_table const&);
+
+// Same as above, but only converts the requests in [first, last).
+std::vector<transfer_request> to_transfer_requests(
+    transfer_request_by_keys_csr const&, platform_table const&,
+    std::size_t const /* first */, std::size_t const /* last */);
 
 // Generates new `transfer_request_keys` based on matched platforms in the old
 // and update state. List of `transfer_request_keys` are always created for the
@@ -82,8 +178,12 @@ std::vector<transfer_request> to_transfer_requests(
 // `transfer_request_keys` is necessary if the profiles (from PPR) necessary for
 // the creation of the `transfer_request_keys` have changed (compared to
 // previous applications).
-std::vector<transfer_request_by_keys>
-generate_all_pair_transfer_requests_by_keys(
+// Origins are processed in parallel and share a single radius query for all
+// profiles; the order of the returned list is deterministic.
+// Neighbours of update locations are computed once: requests from update to old
+// and update are combined per update location, requests from old to update are
+// derived from the same (symmetric) neighbour pairs.
+transfer_request_by_keys_csr generate_all_pair_transfer_requests_by_keys(
     transfer_request_generation_data const&, transfer_request_options const&);
 
 // Returns the new merged `transfer_request_keys` struct.
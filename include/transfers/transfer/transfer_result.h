@@ -1,14 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "transfers/platform/platform_table.h"
+#include "transfers/transfer/routing_stats.h"
+#include "transfers/transfer/thread_placement.h"
 #include "transfers/transfer/transfer_request.h"
 #include "transfers/types.h"
 
 #include "ppr/common/routing_graph.h"
+#include "ppr/routing/input_location.h"
 #include "ppr/routing/routing_query.h"
+#include "ppr/routing/search.h"
 #include "ppr/routing/search_profile.h"
 
 #include "nigiri/types.h"
@@ -38,27 +48,154 @@ struct transfer_result {
   vector<transfer_info> infos_;
 };
 
+// Targets and requests of a single profile within a `routing_task`.
+struct profile_targets {
+  profile_key_t profile_;
+
+  // sorted indices into `routing_task::targets_`
+  std::vector<std::uint32_t> targets_;
+
+  // indices of the `transfer_request`s covered by this profile
+  std::vector<std::size_t> treqs_;
+
+  // symmetric profiles (see `prune_symmetric_pairs`):
+  // mirror_in_: targets (index into `routing_task::targets_`, sorted) that are
+  // not routed by this task; their info is read from the mirror table slot.
+  // mirror_out_: routed targets whose info is written to the mirror table
+  // slot for the reverse pair.
+  std::vector<std::pair<std::uint32_t, std::size_t>> mirror_in_;
+  std::vector<std::pair<std::uint32_t, std::size_t>> mirror_out_;
+};
+
+// Routing unit of `route_multiple_requests`: all `transfer_request`s with the
+// same start platform are routed together. Targets are deduplicated over all
+// profiles; every profile is then routed with a single search to its own
+// targets.
+struct routing_task {
+  platform_idx_t start_;
+
+  // sorted and unique target platforms (union over all profiles)
+  std::vector<platform_idx_t> targets_;
+
+  // one entry per profile used by the requests of the task
+  std::vector<profile_targets> profiles_;
+};
+
+// Groups the given `transfer_request`s by start platform (and profile within
+// a start platform) and returns the resulting list of `routing_task`s.
+std::vector<routing_task> to_routing_tasks(
+    std::vector<transfer_request> const&);
+
+// Removes reverse pairs of symmetric profiles (same route in both directions)
+// from the given `routing_task`s: if both A -> B and B -> A are requested for
+// a symmetric profile, only the search from the platform with the smaller
+// index is run and its result is used for both directions. Returns the number
+// of mirrored pairs (size of the mirror table).
+std::size_t prune_symmetric_pairs(
+    std::vector<routing_task>&, set<profile_key_t> const& /* symmetric */);
+
+// Routing function: returns the routes of a single ppr::routing_query.
+// Default: ::ppr::routing::find_routes_v2 on a routing graph.
+using router_t = std::function<::ppr::routing::search_result(
+    ::ppr::routing::routing_query const&)>;
+
+// Per-worker buffers of `route_routing_task`. The buffers are reused for all
+// tasks routed by a worker, so that their capacity is kept and routing a task
+// does not allocate (apart from the search itself).
+struct routing_scratch {
+  // destinations of the current query (moved into and out of the query)
+  std::vector<::ppr::routing::input_location> destinations_;
+
+  // result: `infos_[i][j]` holds the info of `task.targets_[j]` for
+  // `task.profiles_[i]`
+  std::vector<std::vector<std::optional<transfer_info>>> infos_;
+
+  // instrumentation: if set, every routing query is measured and appended to
+  // `stats_`
+  bool record_stats_{false};
+  std::vector<routing_query_stats> stats_;
+};
+
+// Routes a single `routing_task` and stores the `transfer_info` of every
+// target platform of the task per profile in `scratch.infos_`. Unreached
+// targets (and targets that are not requested for a profile) are empty.
+void route_routing_task(
+    routing_task const&, platform_table const&, router_t const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&,
+    routing_scratch& /* scratch */);
+
+// Returns the estimated routing cost of a `routing_task`: sum over all
+// profiles of the number of targets times the maximum walking distance of
+// the profile.
+double estimate_routing_cost(
+    routing_task const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&);
+
 // Builds a ppr::routing_query using the given `transfer_request` and a map of
 // `profile_keys_t` to `search_profile_` to get the search profile of the
-// `transfer_request`.
+// `transfer_request`. Coordinates and OSM ids of the start and target
+// platforms are read from the given `platform_table`.
 ::ppr::routing::routing_query build_routing_query(
     const hash_map<profile_key_t,
                    ::ppr::routing::search_profile>& /* profiles */,
-    transfer_request const& /* treq */);
+    platform_table const& /* pfs */, transfer_request const& /* treq */);
 
 // Routes a single `transfer_request` and returns the corresponding
 // `transfer_result`. PPR is used for routing.
 transfer_result route_single_request(
-    transfer_request const&, ::ppr::routing_graph const&,
+    transfer_request const&, platform_table const&,
+    ::ppr::routing_graph const&,
     hash_map<profile_key_t, ::ppr::routing::search_profile> const&);
 
 // Routes a batch of `transfer_request`s and returns the corresponding list of
 // `transfer_result`s.
-// Equivalent: Calls `route_single_request` for every
-// `transfer_request`.
+// Requests with the same start platform are routed in one `routing_task`,
+// once per profile; the results are expanded to all of these requests.
+// Pairs of `symmetric` profiles are routed in one direction only.
+// Requests without any reached target do not produce a `transfer_result`.
+// The order of the returned list follows the order of the given requests.
+// If `stats` is given, a measurement of every routing query is appended.
+// Routing runs on the threads of the given placement (default: one unpinned
+// thread per hardware thread).
 std::vector<transfer_result> route_multiple_requests(
-    std::vector<transfer_request> const&, ::ppr::routing_graph const&,
-    hash_map<profile_key_t, ::ppr::routing::search_profile> const&);
+    std::vector<transfer_request> const&, platform_table const&,
+    ::ppr::routing_graph const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&,
+    set<profile_key_t> const& /* symmetric */ = {},
+    std::vector<routing_query_stats>* /* stats */ = nullptr,
+    thread_placement const& /* threads */ = {});
+
+// Same as above, but routes with the given routing function.
+std::vector<transfer_result> route_multiple_requests(
+    std::vector<transfer_request> const&, platform_table const&,
+    router_t const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&,
+    set<profile_key_t> const& /* symmetric */ = {},
+    std::vector<routing_query_stats>* /* stats */ = nullptr,
+    thread_placement const& /* threads */ = {});
+
+// Same as above, but routes the key form requests in [first, last) of the
+// given container. Requests are not converted to `transfer_request`s up front:
+// platforms are looked up while building the routing tasks and the results
+// are expanded by the routing workers. Result order: see above.
+// Requirement: all locations of the requests are contained in `pfs`.
+std::vector<transfer_result> route_multiple_requests(
+    transfer_request_by_keys_csr const&, std::size_t const /* first */,
+    std::size_t const /* last */, platform_table const&,
+    ::ppr::routing_graph const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&,
+    set<profile_key_t> const& /* symmetric */ = {},
+    std::vector<routing_query_stats>* /* stats */ = nullptr,
+    thread_placement const& /* threads */ = {});
+
+// Same as above, but routes with the given routing function.
+std::vector<transfer_result> route_multiple_requests(
+    transfer_request_by_keys_csr const&, std::size_t const /* first */,
+    std::size_t const /* last */, platform_table const&, router_t const&,
+    hash_map<profile_key_t, ::ppr::routing::search_profile> const&,
+    set<profile_key_t> const& /* symmetric */ = {},
+    std::vector<routing_query_stats>* /* stats */ = nullptr,
+    thread_placement const& /* threads */ = {});
 
 // Returns a new merged `transfer_result` struct.
 // Default values used from `lhs` struct.
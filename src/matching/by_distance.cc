@@ -1,11 +1,19 @@
 #include "transfers/matching/by_distance.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <numbers>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "transfers/platform/platform.h"
 #include "transfers/types.h"
 
+#include "geo/latlng.h"
+
 #include "utl/progress_tracker.h"
 
 namespace n = ::nigiri;
@@ -14,30 +22,143 @@ namespace transfers {
 
 std::vector<matching_result> distance_matcher::matching() {
   auto matches = std::vector<matching_result>{};
+  auto const& coords = data_.locations_to_match_.coordinates_;
+
+  for (auto const& group : group_locations()) {
+    // match group and platform: match first location to nearest platform
+    auto const [has_match, match] =
+        match_by_distance(data_.locations_to_match_.get(group.front()));
+
+    // apply match to all locations of the group; locations out of the
+    // matching distance of the group platform are matched on their own
+    for (auto const idx : group) {
+      if (has_match && in_matching_dist(coords[idx], match.pf_)) {
+        matches.emplace_back(matching_result{match.pf_, location(coords[idx])});
+        continue;
+      }
+      if (idx == group.front()) {
+        continue;
+      }
+
+      auto [has_own_match, own_match] =
+          match_by_distance(data_.locations_to_match_.get(idx));
+      if (has_own_match) {
+        matches.emplace_back(std::move(own_match));
+      }
+    }
+  }
+
+  return matches;
+}
+
+// approximate length of one degree latitude in meters
+constexpr auto const kMetersPerDegree = 111'320.0;
+
+std::vector<std::vector<n::location_idx_t>> distance_matcher::group_locations()
+    const {
+  auto groups = std::vector<std::vector<n::location_idx_t>>{};
+  auto root_to_groups = hash_map<std::uint32_t, std::vector<std::size_t>>{};
+  auto const& coords = data_.locations_to_match_.coordinates_;
+
+  // Returns whether the given position lies within `group_tolerance_` meters
+  // of the first location of group `g`.
+  auto const is_close = [&](std::size_t const g, geo::latlng const& pos) {
+    return geo::distance(coords[groups[g].front()], pos) <=
+           options_.group_tolerance_;
+  };
+
+  // grid of the first locations of all groups; cells span `cell_deg`
+  // degrees (>= group_tolerance_ meters in latitude direction)
+  auto const cell_deg =
+      std::max(options_.group_tolerance_, 1.0) / kMetersPerDegree;
+  auto grid = hash_map<std::uint64_t, std::vector<std::size_t>>{};
+  auto const get_cell = [&](double const deg) {
+    return static_cast<std::int32_t>(std::floor(deg / cell_deg));
+  };
+  auto const cell_key = [](std::int32_t const lat, std::int32_t const lng) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(lat))
+            << 32U) |
+           static_cast<std::uint32_t>(lng);
+  };
+
+  // Returns the group whose first location lies within `group_tolerance_`
+  // meters of the given position (if any).
+  auto const find_close_group = [&](geo::latlng const& pos) {
+    // longitude cells are shorter than group_tolerance_ away from the equator
+    auto const max_abs_lat = std::min(std::abs(pos.lat_) + cell_deg, 89.0);
+    auto const lng_cells = static_cast<std::int32_t>(
+        std::ceil(1.0 / std::cos(max_abs_lat * std::numbers::pi / 180.0)));
+
+    auto const lat_cell = get_cell(pos.lat_);
+    auto const lng_cell = get_cell(pos.lng_);
+    for (auto dlat = -1; dlat <= 1; ++dlat) {
+      for (auto dlng = -lng_cells; dlng <= lng_cells; ++dlng) {
+        auto const it = grid.find(cell_key(lat_cell + dlat, lng_cell + dlng));
+        if (it == end(grid)) {
+          continue;
+        }
+        for (auto const g : it->second) {
+          if (is_close(g, pos)) {
+            return std::optional{g};
+          }
+        }
+      }
+    }
+    return std::optional<std::size_t>{};
+  };
 
   auto progress_tracker = utl::get_active_progress_tracker();
 
   for (auto i = std::size_t{0U}; i < data_.locations_to_match_.ids_.size();
        ++i) {
     progress_tracker->increment();
-    auto nloc = data_.locations_to_match_.get(n::location_idx_t{i});
+    auto const idx = n::location_idx_t{i};
+    auto const nloc = data_.locations_to_match_.get(idx);
 
     if (data_.already_matched_nloc_keys_.count(location(nloc.pos_).key()) ==
         1) {
       continue;
     }
 
-    // match location and platform: match to nearest platform
-    auto [has_match, match] = match_by_distance(nloc);
-
-    if (!has_match) {
+    if (!options_.group_locations_) {
+      groups.push_back({idx});
       continue;
     }
 
-    matches.emplace_back(match);
+    // a location joins the first group of its parent station (a parent
+    // station belongs to the groups of its children) or else any group
+    // whose first location lies within `group_tolerance_` meters: only
+    // co-located stop points share a match
+    auto const root =
+        nloc.parent_ == n::location_idx_t::invalid() ? idx : nloc.parent_;
+    auto& station_groups = root_to_groups[cista::to_idx(root)];
+    auto const station_group = std::find_if(
+        begin(station_groups), end(station_groups),
+        [&](std::size_t const g) { return is_close(g, nloc.pos_); });
+    auto group = station_group != end(station_groups)
+                     ? std::optional{*station_group}
+                     : find_close_group(nloc.pos_);
+
+    if (!group.has_value()) {
+      group = groups.size();
+      groups.emplace_back();
+      grid[cell_key(get_cell(nloc.pos_.lat_), get_cell(nloc.pos_.lng_))]
+          .emplace_back(*group);
+    }
+    groups[*group].emplace_back(idx);
+    if (station_group == end(station_groups)) {
+      station_groups.emplace_back(*group);
+    }
   }
 
-  return matches;
+  return groups;
+}
+
+bool distance_matcher::in_matching_dist(geo::latlng const& coord,
+                                        platform const& pf) const {
+  auto const dist = geo::distance(coord, pf.loc_);
+  return dist <= options_.max_matching_dist_ &&
+         (!pf.is_bus_stop_ || dist <= options_.max_bus_stop_matching_dist_);
 }
 
 std::pair<bool, matching_result> distance_matcher::match_by_distance(
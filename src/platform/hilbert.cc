@@ -0,0 +1,38 @@
+#include "transfers/platform/hilbert.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace transfers {
+
+// Maps `value` from [min, max] to [0, 2^32 - 1].
+std::uint32_t to_grid(double const value, double const min, double const max) {
+  constexpr auto const kGridMax = static_cast<double>(0xFFFF'FFFFU);
+  return static_cast<std::uint32_t>(
+      std::clamp((value - min) / (max - min), 0.0, 1.0) * kGridMax);
+}
+
+std::uint64_t hilbert_index(geo::latlng const& pos) {
+  auto x = to_grid(pos.lng_, -180.0, 180.0);
+  auto y = to_grid(pos.lat_, -90.0, 90.0);
+
+  auto d = std::uint64_t{0U};
+  for (auto s = std::uint32_t{1U} << 31U; s > 0U; s >>= 1U) {
+    auto const rx = (x & s) != 0U ? 1U : 0U;
+    auto const ry = (y & s) != 0U ? 1U : 0U;
+    d += static_cast<std::uint64_t>(s) * s * ((3U * rx) ^ ry);
+
+    // rotate the quadrant
+    if (ry == 0U) {
+      if (rx == 1U) {
+        x = ~x;
+        y = ~y;
+      }
+      std::swap(x, y);
+    }
+  }
+
+  return d;
+}
+
+}  // namespace transfers
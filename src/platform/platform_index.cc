@@ -1,5 +1,7 @@
 #include "transfers/platform/platform_index.h"
 
+#include <algorithm>
+
 #include "utl/pipes/all.h"
 #include "utl/pipes/remove_if.h"
 #include "utl/pipes/transform.h"
@@ -38,4 +40,17 @@ std::vector<size_t> platform_index::get_other_platforms_in_radius(
          utl::vec();
 }
 
+std::vector<std::pair<double, std::size_t>>
+platform_index::get_other_platforms_in_radius_with_distance_info(
+    platform const& pf, double const radius) const {
+  auto res =
+      utl::all(platform_index_.in_radius_with_distance(pf.loc_, radius)) |
+      utl::remove_if([this, &pf](std::pair<double, std::size_t> const r) {
+        return platforms_[r.second] == pf;
+      }) |
+      utl::vec();
+  std::sort(begin(res), end(res));
+  return res;
+}
+
 }  // namespace transfers
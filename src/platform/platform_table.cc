@@ -0,0 +1,22 @@
+#include "transfers/platform/platform_table.h"
+
+#include "transfers/platform/to_ppr.h"
+
+namespace transfers {
+
+void platform_table::add(location_key_t const loc_key, platform const& pf) {
+  if (loc_to_pf_.count(loc_key) == 1) {
+    return;  // location already known
+  }
+
+  auto const [it, inserted] = pf_key_to_idx_.emplace(
+      pf.key(), static_cast<platform_idx_t>(platforms_.size()));
+  if (inserted) {
+    platforms_.emplace_back(pf);
+    input_locs_.emplace_back(to_input_location(pf));
+  }
+
+  loc_to_pf_.emplace(loc_key, it->second);
+}
+
+}  // namespace transfers
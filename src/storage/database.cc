@@ -1,5 +1,7 @@
 #include "transfers/storage/database.h"
 
+#include <algorithm>
+#include <string>
 #include <string_view>
 
 #include "cista/hashing.h"
@@ -16,14 +18,76 @@ constexpr auto const kPlatformsDB = "platforms";
 constexpr auto const kMatchingsDB = "matchings";
 constexpr auto const kTransReqsDB = "transreqs";
 constexpr auto const kTransfersDB = "transfers";
+constexpr auto const kRouteCacheDB = "routecache";
+constexpr auto const kMetaDB = "meta";
+constexpr auto const kProfileHashesDB = "profilehashes";
+
+// meta keys
+constexpr auto const kRouteCacheFingerprintKey = "routecache_rg_fingerprint";
+constexpr auto const kRoutingProgressKey = "routing_progress";
 
 inline std::string_view view(cista::byte_buf const& b) {
   return std::string_view{reinterpret_cast<char const*>(b.data()), b.size()};
 }
 
+// Returns the meta key of the given routing phase.
+inline std::string phase_key(std::string_view const key,
+                             std::uint8_t const phase) {
+  return std::string{key} + "_" + std::to_string(phase);
+}
+
+profile_mask get_profile_mask(transfer_request_by_keys_csr const& treqs_k) {
+  auto mask = profile_mask{};
+  for (auto const prf_key : treqs_k.profiles_) {
+    mask[prf_key / 64U] |= std::uint64_t{1U} << (prf_key % 64U);
+  }
+  return mask;
+}
+
+set<profile_key_t> get_profiles(profile_mask const& mask) {
+  auto profiles = set<profile_key_t>{};
+  for (auto i = 0U; i < mask.size() * 64U; ++i) {
+    if ((mask[i / 64U] & (std::uint64_t{1U} << (i % 64U))) != 0U) {
+      profiles.insert(static_cast<profile_key_t>(i));
+    }
+  }
+  return profiles;
+}
+
+routing_run get_routing_run(
+    transfer_request_by_keys_csr const& requests,
+    std::optional<routing_progress> const& progress,
+    std::function<transfer_request_by_keys_csr(
+        set<profile_key_t> const&)> const& get_stored_requests) {
+  auto run = routing_run{};
+  run.profiles_ = get_profile_mask(requests);
+  if (!progress.has_value()) {
+    run.requests_ = requests;
+    return run;
+  }
+
+  if (progress->run_hash_ == requests.hash()) {
+    run.requests_ = requests;
+    run.first_ = std::min(static_cast<std::size_t>(progress->n_stored_),
+                          requests.size());
+    return run;
+  }
+
+  // rebuild the requests of the interrupted run
+  for (auto i = std::size_t{0U}; i < run.profiles_.size(); ++i) {
+    run.profiles_[i] |= progress->profiles_[i];
+  }
+  run.requests_ = get_stored_requests(get_profiles(run.profiles_));
+  if (run.requests_.hash() == progress->run_hash_) {
+    run.first_ = std::min(static_cast<std::size_t>(progress->n_stored_),
+                          run.requests_.size());
+  }
+  return run;
+}
+
 database::database(fs::path const& db_file_path,
                    std::size_t const db_max_size) {
-  env_.set_maxdbs(5);
+  env_.set_maxdbs(8);
   env_.set_mapsize(db_max_size);
   auto flags = lmdb::env_open_flags::NOSUBDIR | lmdb::env_open_flags::NOSYNC;
   env_.open(db_file_path.string().c_str(), flags);
@@ -38,6 +102,9 @@ void database::init() {
   matchings_dbi(txn, lmdb::dbi_flags::CREATE);
   transreqs_dbi(txn, lmdb::dbi_flags::CREATE);
   transfers_dbi(txn, lmdb::dbi_flags::CREATE);
+  routecache_dbi(txn, lmdb::dbi_flags::CREATE);
+  meta_dbi(txn, lmdb::dbi_flags::CREATE);
+  profilehashes_dbi(txn, lmdb::dbi_flags::CREATE);
 
   // find highes profiles id in db
   auto cur = lmdb::cursor{txn, profiles_db};
@@ -233,20 +300,22 @@ hash_map<location_key_t, platform> database::get_loc_to_pf_matchings() {
 }
 
 std::vector<std::size_t> database::put_transfer_requests_by_keys(
-    std::vector<transfer_request_by_keys> const& treqs_k) {
+    transfer_request_by_keys_csr const& treqs_k) {
   auto added_indices = std::vector<std::size_t>{};
 
   auto txn = lmdb::txn{env_};
   auto transreqs_db = transreqs_dbi(txn);
 
-  for (auto const& [idx, treq_k] : utl::enumerate(treqs_k)) {
+  for (auto idx = std::size_t{0U}; idx < treqs_k.size(); ++idx) {
+    auto const treq_k = treqs_k[idx];
     auto const treq_key = treq_k.key();
 
     if (auto const r = txn.get(transreqs_db, treq_key); r.has_value()) {
       continue;  // transfer request already in db
     }
 
-    auto const serialized_treq = cista::serialize(treq_k);
+    auto const serialized_treq =
+        cista::serialize(treq_k.to_transfer_request_by_keys());
     txn.put(transreqs_db, treq_key, view(serialized_treq));
     added_indices.emplace_back(idx);
   }
@@ -259,15 +328,15 @@ std::vector<std::size_t> database::put_transfer_requests_by_keys(
  * merge and update: transfer_request_keys in db
  */
 std::vector<std::size_t> database::update_transfer_requests_by_keys(
-    std::vector<transfer_request_by_keys> const& treqs_k) {
+    transfer_request_by_keys_csr const& treqs_k) {
   auto updated_indices = std::vector<std::size_t>{};
   auto treq_chashing = cista::hashing<transfer_request_by_keys>{};
 
   auto txn = lmdb::txn{env_};
   auto transreqs_db = transreqs_dbi(txn);
 
-  for (auto const& [idx, treq] : utl::enumerate(treqs_k)) {
-    auto treq_key = treq.key();
+  for (auto idx = std::size_t{0U}; idx < treqs_k.size(); ++idx) {
+    auto const treq_key = treqs_k[idx].key();
 
     if (auto const r = txn.get(transreqs_db, treq_key); !r.has_value()) {
       continue;  // transfer request not in db
@@ -281,7 +350,8 @@ std::vector<std::size_t> database::update_transfer_requests_by_keys(
     auto treq_from_db =
         cista::copy_from_potentially_unaligned<transfer_request_by_keys>(
             trans_req_by_key_serialized);
-    auto merged = merge(treq_from_db, treq);
+    auto merged =
+        merge(treq_from_db, treqs_k[idx].to_transfer_request_by_keys());
 
     // update entry only in case of changes
     if (treq_chashing(treq_from_db) == treq_chashing(merged)) {
@@ -300,9 +370,9 @@ std::vector<std::size_t> database::update_transfer_requests_by_keys(
   return updated_indices;
 }
 
-std::vector<transfer_request_by_keys> database::get_transfer_requests_by_keys(
+transfer_request_by_keys_csr database::get_transfer_requests_by_keys(
     set<profile_key_t> const& ppr_profiles) {
-  auto treqs_k = std::vector<transfer_request_by_keys>{};
+  auto treqs_k = transfer_request_by_keys_csr{};
 
   auto txn = lmdb::txn{env_, lmdb::txn_flags::RDONLY};
   auto transreqs_db = transreqs_dbi(txn);
@@ -420,6 +490,185 @@ std::vector<transfer_result> database::get_transfer_results(
   return trs;
 }
 
+std::optional<std::uint64_t> database::get_route_cache_fingerprint() {
+  auto txn = lmdb::txn{env_, lmdb::txn_flags::RDONLY};
+  auto meta_db = meta_dbi(txn);
+
+  auto const r = txn.get(meta_db, kRouteCacheFingerprintKey);
+  if (!r.has_value()) {
+    return std::nullopt;
+  }
+  return cista::copy_from_potentially_unaligned<std::uint64_t>(r.value());
+}
+
+/**
+ * delete all cached routes and set the routing graph fingerprint
+ */
+void database::reset_route_cache(std::uint64_t const rg_fingerprint) {
+  auto txn = lmdb::txn{env_};
+  auto routecache_db = routecache_dbi(txn);
+  auto meta_db = meta_dbi(txn);
+
+  txn.dbi_clear(routecache_db);
+
+  auto const serialized_fp = cista::serialize(rg_fingerprint);
+  txn.put(meta_db, kRouteCacheFingerprintKey, view(serialized_fp));
+
+  txn.commit();
+}
+
+std::vector<std::optional<route_cache_entry>> database::get_cached_routes(
+    std::vector<std::string> const& keys) {
+  auto entries = std::vector<std::optional<route_cache_entry>>{};
+  entries.reserve(keys.size());
+
+  auto txn = lmdb::txn{env_, lmdb::txn_flags::RDONLY};
+  auto routecache_db = routecache_dbi(txn);
+
+  for (auto const& key : keys) {
+    auto const r = txn.get(routecache_db, key);
+    if (!r.has_value()) {
+      entries.emplace_back(std::nullopt);
+      continue;
+    }
+    entries.emplace_back(
+        cista::copy_from_potentially_unaligned<route_cache_entry>(r.value()));
+  }
+
+  return entries;
+}
+
+/**
+ * insert or overwrite: cached routes in db
+ */
+void database::put_cached_routes(
+    std::vector<std::pair<std::string, route_cache_entry>> const& entries) {
+  auto txn = lmdb::txn{env_};
+  auto routecache_db = routecache_dbi(txn);
+
+  for (auto const& [key, entry] : entries) {
+    auto const serialized_entry = cista::serialize(entry);
+    txn.put(routecache_db, key, view(serialized_entry));
+  }
+
+  txn.commit();
+}
+
+hash_map<profile_key_t, std::uint64_t> database::get_profile_hashes() {
+  auto hashes = hash_map<profile_key_t, std::uint64_t>{};
+
+  auto txn = lmdb::txn{env_, lmdb::txn_flags::RDONLY};
+  auto profilehashes_db = profilehashes_dbi(txn);
+  auto cur = lmdb::cursor{txn, profilehashes_db};
+
+  for (auto entry = cur.get(lmdb::cursor_op::FIRST); entry.has_value();
+       entry = cur.get(lmdb::cursor_op::NEXT)) {
+    auto const [prf_key, hash] = entry.value();
+    hashes.emplace(
+        cista::copy_from_potentially_unaligned<profile_key_t>(prf_key),
+        cista::copy_from_potentially_unaligned<std::uint64_t>(hash));
+  }
+
+  cur.reset();
+  return hashes;
+}
+
+/**
+ * insert or overwrite: search profile parameter hashes in db
+ */
+void database::put_profile_hashes(
+    hash_map<profile_key_t, std::uint64_t> const& hashes) {
+  auto txn = lmdb::txn{env_};
+  auto profilehashes_db = profilehashes_dbi(txn);
+
+  for (auto const& [prf_key, hash] : hashes) {
+    auto const serialized_key = cista::serialize(prf_key);
+    auto const serialized_hash = cista::serialize(hash);
+    txn.put(profilehashes_db, view(serialized_key), view(serialized_hash));
+  }
+
+  txn.commit();
+}
+
+/**
+ * delete all transfer requests and transfer results of the given profiles
+ */
+void database::delete_transfers_of_profiles(
+    set<profile_key_t> const& profiles) {
+  auto txn = lmdb::txn{env_};
+  auto transreqs_db = transreqs_dbi(txn);
+  auto transfers_db = transfers_dbi(txn);
+
+  auto treq_keys = std::vector<std::string>{};
+  auto treqs_cur = lmdb::cursor{txn, transreqs_db};
+  for (auto entry = treqs_cur.get(lmdb::cursor_op::FIRST); entry.has_value();
+       entry = treqs_cur.get(lmdb::cursor_op::NEXT)) {
+    auto const [key, trans_req_by_keys] = entry.value();
+    auto const db_treq_k =
+        cista::copy_from_potentially_unaligned<transfer_request_by_keys>(
+            trans_req_by_keys);
+    if (profiles.count(db_treq_k.profile_) == 1) {
+      treq_keys.emplace_back(key);
+    }
+  }
+  treqs_cur.reset();
+
+  auto tres_keys = std::vector<std::string>{};
+  auto tres_cur = lmdb::cursor{txn, transfers_db};
+  for (auto entry = tres_cur.get(lmdb::cursor_op::FIRST); entry.has_value();
+       entry = tres_cur.get(lmdb::cursor_op::NEXT)) {
+    auto const [key, trans_res] = entry.value();
+    auto const db_tr =
+        cista::copy_from_potentially_unaligned<transfer_result>(trans_res);
+    if (profiles.count(db_tr.profile_) == 1) {
+      tres_keys.emplace_back(key);
+    }
+  }
+  tres_cur.reset();
+
+  for (auto const& key : treq_keys) {
+    txn.del(transreqs_db, key);
+  }
+  for (auto const& key : tres_keys) {
+    txn.del(transfers_db, key);
+  }
+
+  txn.commit();
+}
+
+std::optional<routing_progress> database::get_routing_progress(
+    std::uint8_t const phase) {
+  auto txn = lmdb::txn{env_, lmdb::txn_flags::RDONLY};
+  auto meta_db = meta_dbi(txn);
+
+  auto const r = txn.get(meta_db, phase_key(kRoutingProgressKey, phase));
+  if (!r.has_value()) {
+    return std::nullopt;
+  }
+  return cista::copy_from_potentially_unaligned<routing_progress>(r.value());
+}
+
+void database::put_routing_progress(std::uint8_t const phase,
+                                    routing_progress const& progress) {
+  auto txn = lmdb::txn{env_};
+  auto meta_db = meta_dbi(txn);
+
+  auto const serialized_progress = cista::serialize(progress);
+  txn.put(meta_db, phase_key(kRoutingProgressKey, phase),
+          view(serialized_progress));
+
+  txn.commit();
+}
+
+void database::delete_routing_progress(std::uint8_t const phase) {
+  auto txn = lmdb::txn{env_};
+  auto meta_db = meta_dbi(txn);
+
+  txn.del(meta_db, phase_key(kRoutingProgressKey, phase));
+
+  txn.commit();
+}
+
 lmdb::txn::dbi database::profiles_dbi(lmdb::txn& txn, lmdb::dbi_flags flags) {
   return txn.dbi_open(kProfilesDB, flags);
 }
@@ -444,4 +693,19 @@ lmdb::txn::dbi database::transfers_dbi(lmdb::txn& txn,
   return txn.dbi_open(kTransfersDB, flags);
 }
 
+lmdb::txn::dbi database::routecache_dbi(lmdb::txn& txn,
+                                        lmdb::dbi_flags const flags) {
+  return txn.dbi_open(kRouteCacheDB, flags);
+}
+
+lmdb::txn::dbi database::meta_dbi(lmdb::txn& txn,
+                                  lmdb::dbi_flags const flags) {
+  return txn.dbi_open(kMetaDB, flags);
+}
+
+lmdb::txn::dbi database::profilehashes_dbi(lmdb::txn& txn,
+                                           lmdb::dbi_flags const flags) {
+  return txn.dbi_open(kProfileHashesDB, flags);
+}
+
 }  // namespace transfers
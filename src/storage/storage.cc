@@ -1,6 +1,7 @@
 #include "transfers/storage/storage.h"
 
 #include "transfers/storage/to_nigiri.h"
+#include "transfers/transfer/profiles.h"
 
 #include "nigiri/footpath.h"
 #include "nigiri/types.h"
@@ -43,11 +44,22 @@ hash_map<location_key_t, platform> storage::get_all_matchings() {
   return all_matchings;
 }
 
+platform_table storage::get_platform_table() {
+  auto pfs = platform_table{};
+  for (auto const& [loc_key, pf] : old_state_.matches_) {
+    pfs.add(loc_key, pf);
+  }
+  for (auto const& [loc_key, pf] : update_state_.matches_) {
+    pfs.add(loc_key, pf);
+  }
+  return pfs;
+}
+
 bool storage::has_transfer_requests_by_keys(data_request_type const req_type) {
   return get_transfer_requests_by_keys(req_type).empty();
 }
 
-std::vector<transfer_request_by_keys> storage::get_transfer_requests_by_keys(
+transfer_request_by_keys_csr const& storage::get_transfer_requests_by_keys(
     data_request_type const req_type) {
   switch (req_type) {
     case data_request_type::kPartialOld:
@@ -55,13 +67,25 @@ std::vector<transfer_request_by_keys> storage::get_transfer_requests_by_keys(
     case data_request_type::kPartialUpdate:
       return update_state_.transfer_requests_by_keys_;
     case data_request_type::kFull:
-      auto full = old_state_.transfer_requests_by_keys_;
-      full.insert(full.end(), update_state_.transfer_requests_by_keys_.begin(),
-                  update_state_.transfer_requests_by_keys_.end());
-      return full;
+      // built once per old/update state
+      if (full_transfer_requests_by_keys_valid_) {
+        return full_transfer_requests_by_keys_;
+      }
+      full_transfer_requests_by_keys_.clear();
+      full_transfer_requests_by_keys_.reserve(
+          old_state_.transfer_requests_by_keys_.size() +
+              update_state_.transfer_requests_by_keys_.size(),
+          old_state_.transfer_requests_by_keys_.to_locs_.size() +
+              update_state_.transfer_requests_by_keys_.to_locs_.size());
+      full_transfer_requests_by_keys_.append(
+          old_state_.transfer_requests_by_keys_);
+      full_transfer_requests_by_keys_.append(
+          update_state_.transfer_requests_by_keys_);
+      full_transfer_requests_by_keys_valid_ = true;
+      return full_transfer_requests_by_keys_;
   }
 
-  return {};
+  return full_transfer_requests_by_keys_;
 }
 
 transfer_request_generation_data
@@ -107,10 +131,11 @@ void storage::add_new_matching_results(
 }
 
 void storage::add_new_transfer_requests_by_keys(
-    std::vector<transfer_request_by_keys> const& treqs_k) {
+    transfer_request_by_keys_csr const& treqs_k) {
   auto const updated_in_db = db_.update_transfer_requests_by_keys(treqs_k);
   auto const added_to_db = db_.put_transfer_requests_by_keys(treqs_k);
   update_state_.transfer_requests_by_keys_.clear();
+  full_transfer_requests_by_keys_valid_ = false;
 
   for (auto const i : updated_in_db) {
     update_state_.transfer_requests_by_keys_.emplace_back(treqs_k[i]);
@@ -123,9 +148,14 @@ void storage::add_new_transfer_requests_by_keys(
 
 void storage::add_new_transfer_results(
     std::vector<transfer_result> const& tres) {
+  update_state_.transfer_results_.clear();
+  append_new_transfer_results(tres);
+}
+
+void storage::append_new_transfer_results(
+    std::vector<transfer_result> const& tres) {
   auto const updated_in_db = db_.update_transfer_results(tres);
   auto const added_to_db = db_.put_transfer_results(tres);
-  update_state_.transfer_results_.clear();
 
   for (auto const i : updated_in_db) {
     update_state_.transfer_results_.emplace_back(tres[i]);
@@ -136,6 +166,79 @@ void storage::add_new_transfer_results(
   }
 }
 
+void storage::init_route_cache(std::uint64_t const rg_fingerprint) {
+  if (db_.get_route_cache_fingerprint() != rg_fingerprint) {
+    db_.reset_route_cache(rg_fingerprint);
+  }
+}
+
+std::vector<std::optional<route_cache_entry>> storage::get_cached_routes(
+    std::vector<std::string> const& keys) {
+  return db_.get_cached_routes(keys);
+}
+
+void storage::add_cached_routes(
+    std::vector<std::pair<std::string, route_cache_entry>> const& entries) {
+  db_.put_cached_routes(entries);
+}
+
+set<profile_key_t> storage::invalidate_changed_profiles() {
+  auto const stored = db_.get_profile_hashes();
+
+  auto changed = set<profile_key_t>{};
+  for (auto const& [prf_key, profile] : profile_key_to_search_profile_) {
+    if (auto const it = stored.find(prf_key);
+        it != end(stored) && it->second != hash_search_profile(profile)) {
+      changed.insert(prf_key);
+    }
+  }
+
+  if (!changed.empty()) {
+    db_.delete_transfers_of_profiles(changed);
+    load_old_state_from_db(used_profiles_);
+  }
+
+  return changed;
+}
+
+void storage::store_profile_hashes() {
+  auto hashes = hash_map<profile_key_t, std::uint64_t>{};
+  for (auto const& [prf_key, profile] : profile_key_to_search_profile_) {
+    hashes.emplace(prf_key, hash_search_profile(profile));
+  }
+  db_.put_profile_hashes(hashes);
+}
+
+routing_run storage::start_routing_run(
+    data_request_type const request_type,
+    transfer_request_by_keys_csr const& treqs_k) {
+  auto const phase = static_cast<std::uint8_t>(request_type);
+  auto run = get_routing_run(
+      treqs_k, db_.get_routing_progress(phase),
+      [&](set<profile_key_t> const& profiles) {
+        return db_.get_transfer_requests_by_keys(profiles);
+      });
+  if (run.first_ == 0U) {
+    db_.put_routing_progress(phase, {run.requests_.hash(), 0U, run.profiles_});
+  }
+  return run;
+}
+
+bool storage::has_interrupted_routing_run(
+    data_request_type const request_type) {
+  return db_.get_routing_progress(static_cast<std::uint8_t>(request_type))
+      .has_value();
+}
+
+void storage::set_routing_progress(data_request_type const request_type,
+                                   routing_progress const& progress) {
+  db_.put_routing_progress(static_cast<std::uint8_t>(request_type), progress);
+}
+
+void storage::reset_routing_progress(data_request_type const request_type) {
+  db_.delete_routing_progress(static_cast<std::uint8_t>(request_type));
+}
+
 void storage::load_old_state_from_db(set<profile_key_t> const& profile_keys) {
   auto old_pfs = db_.get_platforms();
   old_state_.pfs_idx_ = std::make_unique<platform_index>(old_pfs);
@@ -143,6 +246,7 @@ void storage::load_old_state_from_db(set<profile_key_t> const& profile_keys) {
   old_state_.matches_ = db_.get_loc_to_pf_matchings();
   old_state_.transfer_requests_by_keys_ =
       db_.get_transfer_requests_by_keys(profile_keys);
+  full_transfer_requests_by_keys_valid_ = false;
   old_state_.transfer_results_ = db_.get_transfer_results(profile_keys);
 
   auto matched_pfs = std::vector<platform>{};
@@ -1,18 +1,50 @@
 #include "transfers/storage/updater.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "transfers/matching/by_distance.h"
 #include "transfers/platform/extract.h"
+#include "transfers/transfer/profiles.h"
+#include "transfers/transfer/route_cache.h"
+#include "transfers/transfer/routing_shard.h"
+#include "transfers/transfer/routing_stats.h"
 #include "transfers/transfer/transfer_request.h"
 #include "transfers/transfer/transfer_result.h"
 
 #include "ppr/common/routing_graph.h"
 #include "ppr/serialization/reader.h"
 
+#include "fmt/core.h"
+
+#include "utl/verify.h"
+
 namespace p = ::ppr;
+namespace pr = ::ppr::routing;
 namespace ps = ::ppr::serialization;
 
 namespace transfers {
 
+// maximum number of routed batches waiting for the writer thread
+constexpr auto const kResultQueueCapacity = std::size_t{2U};
+
+// Returns the name of the routing phase of the given `data_request_type`.
+std::string_view get_phase_name(data_request_type const request_type) {
+  switch (request_type) {
+    case data_request_type::kPartialOld: return "old";
+    case data_request_type::kPartialUpdate: return "update";
+    case data_request_type::kFull: return "full";
+  }
+  return "unknown";
+}
+
 void storage_updater::full_update() {
   // 1st: extract all platforms from a given osm file
   extract_and_store_osm_platforms();
@@ -20,11 +52,14 @@ void storage_updater::full_update() {
   // 2nd: update osm_id and location_idx: match osm and nigiri locations
   match_and_store_matches_by_distance();
 
-  // 3rd: generate transfer requests
+  // 3rd: generate transfer requests (drop transfers of changed profiles)
+  storage_.invalidate_changed_profiles();
   generate_and_store_transfer_requests();
 
-  // 4th: precompute transfers (generate transfer results)
+  // 4th: precompute transfers (generate transfer results) and record the
+  // profile parameters they are based on
   generate_and_store_transfer_results(data_request_type::kPartialUpdate);
+  storage_.store_profile_hashes();
 
   // 5th: update timetable
   storage_.update_tt(nigiri_dump_path_);
@@ -43,16 +78,24 @@ void storage_updater::partial_update(transfers::first_update const first,
       generate_and_store_transfer_requests();
       break;
     case first_update::kProfiles:
+      // drop stale transfers of changed profiles
+      storage_.invalidate_changed_profiles();
       generate_and_store_transfer_requests(true);
       break;
+    case first_update::kChangedProfiles:
+      regenerate_transfer_requests_of_changed_profiles();
+      break;
   }
 
   // 4th: precompute transfers (generate transfer results)
   switch (routing) {
     case routing_type::kNoRouting: break;
     case routing_type::kPartialRouting:
-      // do not load ppr graph if there are no routing requests
+      // do not load ppr graph if there are no routing requests (neither new
+      // ones nor ones of an interrupted run)
       if (storage_.has_transfer_requests_by_keys(
+              data_request_type::kPartialUpdate) &&
+          !storage_.has_interrupted_routing_run(
               data_request_type::kPartialUpdate)) {
         break;
       }
@@ -67,10 +110,78 @@ void storage_updater::partial_update(transfers::first_update const first,
       break;
   }
 
+  // record the profile parameters once the transfers of the changed profiles
+  // are routed
+  if (routing != routing_type::kNoRouting &&
+      (first == first_update::kProfiles ||
+       first == first_update::kChangedProfiles)) {
+    storage_.store_profile_hashes();
+  }
+
   // 5th: update timetable
   storage_.update_tt(nigiri_dump_path_);
 }
 
+std::size_t storage_updater::export_routing_shards(
+    data_request_type const request_type, std::filesystem::path const& dir,
+    std::size_t const n_shards) {
+  auto const shards = make_routing_shards(
+      storage_.get_transfer_requests_by_keys(request_type),
+      storage_.get_all_matchings(), storage_.profile_key_to_profile_name_,
+      storage_.profile_key_to_search_profile_, storage_.symmetric_profiles_,
+      n_shards);
+
+  // results of an earlier export must not be imported
+  remove_routing_shard_files(dir);
+  std::filesystem::create_directories(dir);
+  for (auto i = std::size_t{0U}; i < shards.size(); ++i) {
+    write_routing_shard(routing_shard_path(dir, i), shards[i]);
+  }
+  write_routing_shard_manifest(routing_shard_manifest_path(dir),
+                               make_routing_shard_manifest(shards));
+
+  return shards.size();
+}
+
+void storage_updater::import_routing_shards(std::filesystem::path const& dir,
+                                            std::size_t const n_shards) {
+  // every exported shard must have a result of this export; verified before
+  // anything is stored
+  auto const manifest =
+      read_routing_shard_manifest(routing_shard_manifest_path(dir));
+  utl::verify(manifest.shard_hashes_.size() == n_shards,
+              "{} routing shards exported, {} shards to import",
+              manifest.shard_hashes_.size(), n_shards);
+  for (auto i = std::size_t{0U}; i < n_shards; ++i) {
+    auto const result_path = routing_shard_result_path(dir, i);
+    utl::verify(std::filesystem::exists(result_path),
+                "routing shard {} has not been routed yet", i);
+    utl::verify(read_routing_shard_result(result_path).shard_hash_ ==
+                    manifest.shard_hashes_[i],
+                "routing shard {} result belongs to another export", i);
+  }
+
+  progress_tracker_->status("Import Transfer Results.")
+      .out_bounds(30.F, 90.F)
+      .in_high(n_shards);
+
+  for (auto i = std::size_t{0U}; i < n_shards; ++i) {
+    auto const result =
+        read_routing_shard_result(routing_shard_result_path(dir, i));
+    auto const tres = std::vector<transfer_result>(
+        result.transfer_results_.begin(), result.transfer_results_.end());
+
+    if (i == 0U) {
+      storage_.add_new_transfer_results(merge_by_key(tres));
+    } else {
+      storage_.append_new_transfer_results(merge_by_key(tres));
+    }
+    progress_tracker_->increment();
+  }
+
+  storage_.update_tt(nigiri_dump_path_);
+}
+
 void storage_updater::extract_and_store_osm_platforms() {
   progress_tracker_->status("Extract OSM Platforms")
       .out_bounds(0.F, 5.F)
@@ -88,7 +199,11 @@ void storage_updater::match_and_store_matches_by_distance() {
       .in_high(matching_data.locations_to_match_.ids_.size());
 
   auto matcher = distance_matcher(
-      matching_data, {max_matching_dist_, max_bus_stop_matching_dist_});
+      matching_data,
+      {.max_matching_dist_ = max_matching_dist_,
+       .max_bus_stop_matching_dist_ = max_bus_stop_matching_dist_,
+       .group_locations_ = group_locations_,
+       .group_tolerance_ = group_tolerance_});
 
   progress_tracker_->status("Save Matchings.");
   auto const matchings = matcher.matching();
@@ -100,33 +215,229 @@ void storage_updater::generate_and_store_transfer_requests(
   auto const treq_gen_data = storage_.get_transfer_request_generation_data();
 
   progress_tracker_->status("Generate Transfer Requests.")
-      .out_bounds(15.F, 30.F)
-      .in_high(4 * treq_gen_data.profile_key_to_search_profile_.size());
+      .out_bounds(15.F, 30.F);
   auto const generated_trans_reqs = generate_all_pair_transfer_requests_by_keys(
-      storage_.get_transfer_request_generation_data(),
-      {.old_to_old_ = old_to_old});
+      treq_gen_data, {.old_to_old_ = old_to_old});
+  storage_.add_new_transfer_requests_by_keys(generated_trans_reqs);
+}
+
+void storage_updater::regenerate_transfer_requests_of_changed_profiles() {
+  auto const changed = storage_.invalidate_changed_profiles();
+  if (changed.empty()) {
+    return;
+  }
+
+  // generate transfer requests of the changed profiles only
+  auto treq_gen_data = storage_.get_transfer_request_generation_data();
+  auto changed_profiles = hash_map<profile_key_t, pr::search_profile>{};
+  for (auto const prf_key : changed) {
+    changed_profiles.emplace(
+        prf_key, storage_.profile_key_to_search_profile_.at(prf_key));
+  }
+  treq_gen_data.profile_key_to_search_profile_ = std::move(changed_profiles);
+
+  progress_tracker_->status("Generate Transfer Requests (Changed Profiles).")
+      .out_bounds(15.F, 30.F);
+  auto const generated_trans_reqs = generate_all_pair_transfer_requests_by_keys(
+      treq_gen_data, {.old_to_old_ = true});
   storage_.add_new_transfer_requests_by_keys(generated_trans_reqs);
 }
 
 void storage_updater::generate_and_store_transfer_results(
     data_request_type const request_type) {
-  p::routing_graph rg;
-  ps::read_routing_graph(rg, ppr_rg_path_.string());
-  rg.prepare_for_routing(
-      rg_config_.edge_rtree_size_, rg_config_.area_rtree_size_,
-      rg_config_.lock_rtree_ ? ::ppr::rtree_options::LOCK
-                             : ::ppr::rtree_options::PREFETCH);
+  utl::verify(routing_batch_size_ != 0U, "routing batch size must not be 0");
+
+  auto const pfs = storage_.get_platform_table();
 
-  auto treqs =
-      to_transfer_requests(storage_.get_transfer_requests_by_keys(request_type),
-                           storage_.get_all_matchings());
+  // resume an interrupted run of the same routing phase: its requests are
+  // rebuilt from the stored transfer requests
+  auto const run = storage_.start_routing_run(
+      request_type, storage_.get_transfer_requests_by_keys(request_type));
+  auto const& treqs_k = run.requests_;
+  auto const first = run.first_;
+  auto const run_progress = routing_progress{treqs_k.hash(), 0U, run.profiles_};
 
   progress_tracker_->status("Generate Transfer Results.")
       .out_bounds(30.F, 90.F)
-      .in_high(treqs.size());
+      .in_high(treqs_k.size());
+  progress_tracker_->update(first);
 
-  storage_.add_new_transfer_results(route_multiple_requests(
-      treqs, rg, storage_.profile_key_to_search_profile_));
+  // route cache: cached routes are only valid for the routing graph (tile)
+  // that is used for this run, select it before the first cache lookup
+  auto rg_path = std::filesystem::path{};
+  auto profile_hashes = hash_map<profile_key_t, std::uint64_t>{};
+  if (use_route_cache_ && first < treqs_k.size()) {
+    for (auto const& [prf_key, profile] :
+         storage_.profile_key_to_search_profile_) {
+      profile_hashes.emplace(prf_key, hash_search_profile(profile));
+    }
+    rg_path = get_routing_graph_path(treqs_k, pfs);
+    storage_.init_route_cache(routing_graph_fingerprint(rg_path));
+  }
+
+  // pipeline: batches are stored by a dedicated writer thread while the
+  // next batch is routed
+  auto queue = bounded_queue<result_batch>{kResultQueueCapacity};
+  auto writer_error = std::exception_ptr{};
+  auto writer = std::thread{[&]() {
+    try {
+      store_result_batches(queue, request_type, run_progress);
+    } catch (...) {
+      writer_error = std::current_exception();
+      queue.close();
+    }
+  }};
+
+  auto stats = std::vector<routing_query_stats>{};
+  auto const record_stats = !routing_stats_dir_.empty();
+  auto const threads =
+      make_thread_placement(routing_threads_, get_cpu_topology());
+
+  try {
+    for (auto batch_first = first; batch_first < treqs_k.size();
+         batch_first += routing_batch_size_) {
+      auto const batch_last =
+          std::min(batch_first + routing_batch_size_, treqs_k.size());
+      // route cache: only route pairs without a valid cached route; the
+      // cache lookup needs the expanded requests
+      auto treqs = std::vector<transfer_request>{};
+      auto cached = std::vector<transfer_result>{};
+      if (use_route_cache_) {
+        treqs = to_transfer_requests(treqs_k, pfs, batch_first, batch_last);
+        auto split = split_cached_routes(
+            treqs, pfs,
+            storage_.get_cached_routes(
+                get_route_cache_keys(treqs, pfs, profile_hashes)));
+        cached = std::move(split.cached_);
+        treqs = std::move(split.uncached_);
+        progress_tracker_->increment(batch_last - batch_first - treqs.size());
+      }
+
+      auto routed = std::vector<transfer_result>{};
+      if (!use_route_cache_ || !treqs.empty()) {
+        // do not load ppr graph if there are no routing requests
+        if (rg_path.empty()) {
+          rg_path = get_routing_graph_path(treqs_k, pfs);
+        }
+
+        auto const& rg = get_routing_graph(rg_path);
+        auto* const batch_stats = record_stats ? &stats : nullptr;
+        routed = use_route_cache_
+                     ? route_multiple_requests(
+                           treqs, pfs, rg,
+                           storage_.profile_key_to_search_profile_,
+                           storage_.symmetric_profiles_, batch_stats, threads)
+                     // key form requests are expanded by the routing workers
+                     : route_multiple_requests(
+                           treqs_k, batch_first, batch_last, pfs, rg,
+                           storage_.profile_key_to_search_profile_,
+                           storage_.symmetric_profiles_, batch_stats, threads);
+      }
+
+      auto batch = result_batch{{}, {}, batch_last, batch_first == first};
+      if (use_route_cache_) {
+        batch.cached_routes_ =
+            to_route_cache_entries(treqs, routed, pfs, profile_hashes);
+        routed.insert(end(routed), begin(cached), end(cached));
+      }
+      batch.transfer_results_ = merge_by_key(routed);
+
+      if (!queue.push(std::move(batch))) {
+        break;  // writer failed
+      }
+    }
+  } catch (...) {
+    queue.close();
+    writer.join();
+    throw;
+  }
+
+  queue.close();
+  writer.join();
+  if (writer_error) {
+    std::rethrow_exception(writer_error);
+  }
+
+  if (record_stats) {
+    std::filesystem::create_directories(routing_stats_dir_);
+    write_routing_stats(
+        routing_stats_dir_ /
+            fmt::format("routing_stats_{}.json", get_phase_name(request_type)),
+        summarize_routing_stats(
+            stats, routing_stats_n_slowest_,
+            get_canonical_profiles(storage_.profile_key_to_search_profile_)),
+        pfs, storage_.profile_key_to_profile_name_);
+  }
+
+  storage_.reset_routing_progress(request_type);
+}
+
+void storage_updater::release_routing_graph() {
+  rg_.reset();
+  rg_path_.clear();
+}
+
+p::routing_graph const& storage_updater::get_routing_graph(
+    std::filesystem::path const& rg_path) {
+  if (rg_ != nullptr && rg_path_ == rg_path) {
+    return *rg_;
+  }
+
+  release_routing_graph();
+  auto rg = std::make_unique<p::routing_graph>();
+  ps::read_routing_graph(*rg, rg_path.string());
+  rg->prepare_for_routing(rg_config_.edge_rtree_size_,
+                          rg_config_.area_rtree_size_,
+                          rg_config_.lock_rtree_
+                              ? ::ppr::rtree_options::LOCK
+                              : ::ppr::rtree_options::PREFETCH);
+  rg_ = std::move(rg);
+  rg_path_ = rg_path;
+  return *rg_;
+}
+
+std::filesystem::path storage_updater::get_routing_graph_path(
+    transfer_request_by_keys_csr const& treqs_k, platform_table const& pfs) {
+  if (rg_config_.tiles_.empty() || rg_path_ == ppr_rg_path_) {
+    return ppr_rg_path_;
+  }
+
+  auto max_dist = 0.0;
+  for (auto const& [prf_key, profile] :
+       storage_.profile_key_to_search_profile_) {
+    max_dist = std::max(max_dist, get_max_distance(profile));
+  }
+  auto const region = buffer_box(get_bounding_box(treqs_k, pfs), max_dist);
+
+  // keep the already loaded tile if it covers the region
+  auto const loaded = std::find_if(
+      begin(rg_config_.tiles_), end(rg_config_.tiles_),
+      [&](routing_graph_tile const& tile) { return tile.path_ == rg_path_; });
+  if (rg_ != nullptr && loaded != end(rg_config_.tiles_) &&
+      contains(loaded->bbox_, region)) {
+    return rg_path_;
+  }
+
+  return select_routing_graph(rg_config_.tiles_, region, ppr_rg_path_);
+}
+
+void storage_updater::store_result_batches(
+    bounded_queue<result_batch>& queue, data_request_type const request_type,
+    routing_progress progress) {
+  while (auto batch = queue.pop()) {
+    if (!batch->cached_routes_.empty()) {
+      storage_.add_cached_routes(batch->cached_routes_);
+    }
+
+    // checkpoint: store the results of the batch and the progress
+    if (batch->first_) {
+      storage_.add_new_transfer_results(batch->transfer_results_);
+    } else {
+      storage_.append_new_transfer_results(batch->transfer_results_);
+    }
+    progress.n_stored_ = batch->n_stored_;
+    storage_.set_routing_progress(request_type, progress);
+  }
 }
 
 }  // namespace transfers
@@ -0,0 +1,73 @@
+#include "transfers/transfer/profiles.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "cista/equal_to.h"
+#include "cista/hashing.h"
+
+namespace pr = ::ppr::routing;
+
+namespace transfers {
+
+double get_max_distance(pr::search_profile const& profile) {
+  return profile.walking_speed_ * profile.duration_limit_;
+}
+
+std::uint64_t hash_search_profile(pr::search_profile const& profile) {
+  return cista::hashing<pr::search_profile>{}(profile);
+}
+
+hash_map<profile_key_t, profile_key_t> get_canonical_profiles(
+    hash_map<profile_key_t, pr::search_profile> const& profiles) {
+  auto by_hash = hash_map<std::uint64_t, std::vector<profile_key_t>>{};
+  for (auto const& [prf_key, profile] : profiles) {
+    by_hash[hash_search_profile(profile)].emplace_back(prf_key);
+  }
+
+  // equal hashes do not imply equal parameters: within a hash group, only
+  // profiles with equal parameters are mapped to the same canonical profile
+  auto const equal = cista::equal_to<pr::search_profile>{};
+  auto canonical = hash_map<profile_key_t, profile_key_t>{};
+  for (auto& [hash, group] : by_hash) {
+    std::sort(begin(group), end(group));
+    auto representatives = std::vector<profile_key_t>{};
+    for (auto const prf_key : group) {
+      auto const& profile = profiles.at(prf_key);
+      auto const it =
+          std::find_if(begin(representatives), end(representatives),
+                       [&](profile_key_t const r) {
+                         return equal(profiles.at(r), profile);
+                       });
+      if (it == end(representatives)) {
+        representatives.emplace_back(prf_key);
+        canonical.emplace(prf_key, prf_key);
+      } else {
+        canonical.emplace(prf_key, *it);
+      }
+    }
+  }
+  return canonical;
+}
+
+set<profile_key_t> get_symmetric_canonical_profiles(
+    hash_map<profile_key_t, profile_key_t> const& canonical,
+    set<profile_key_t> const& symmetric) {
+  auto const get_canonical = [&](profile_key_t const prf_key) {
+    auto const it = canonical.find(prf_key);
+    return it == end(canonical) ? prf_key : it->second;
+  };
+
+  auto result = set<profile_key_t>{};
+  for (auto const prf_key : symmetric) {
+    result.insert(get_canonical(prf_key));
+  }
+  for (auto const& [prf_key, canonical_key] : canonical) {
+    if (symmetric.count(prf_key) == 0) {
+      result.erase(canonical_key);
+    }
+  }
+  return result;
+}
+
+}  // namespace transfers
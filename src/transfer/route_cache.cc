@@ -0,0 +1,159 @@
+#include "transfers/transfer/route_cache.h"
+
+#include <cstring>
+
+#include "cista/hash.h"
+
+namespace fs = std::filesystem;
+
+namespace transfers {
+
+std::string route_cache_key(platform const& from, platform const& to,
+                            std::uint64_t const profile_hash) {
+  auto const from_key = from.key();
+  auto const to_key = to.key();
+
+  // route cache key: from platform key + to platform key + profile hash
+  auto key = std::string{};
+  key.resize(from_key.size() + to_key.size() + sizeof(profile_hash));
+  std::memcpy(key.data(), from_key.data(), from_key.size());
+  std::memcpy(key.data() + from_key.size(), to_key.data(), to_key.size());
+  std::memcpy(key.data() + from_key.size() + to_key.size(), &profile_hash,
+              sizeof(profile_hash));
+
+  return key;
+}
+
+std::uint64_t routing_graph_fingerprint(fs::path const& rg_path) {
+  auto const size = static_cast<std::uint64_t>(fs::file_size(rg_path));
+  auto const mtime = static_cast<std::uint64_t>(
+      fs::last_write_time(rg_path).time_since_epoch().count());
+  return cista::hash_combine(cista::BASE_HASH, size, mtime);
+}
+
+std::vector<std::string> get_route_cache_keys(
+    std::vector<transfer_request> const& treqs, platform_table const& pfs,
+    hash_map<profile_key_t, std::uint64_t> const& profile_hashes) {
+  auto keys = std::vector<std::string>{};
+
+  for (auto const& treq : treqs) {
+    auto const& from = pfs.get(treq.transfer_start_);
+    auto const prf_hash = profile_hashes.at(treq.profile_);
+    for (auto const target : treq.transfer_targets_) {
+      keys.emplace_back(route_cache_key(from, pfs.get(target), prf_hash));
+    }
+  }
+
+  return keys;
+}
+
+route_cache_split split_cached_routes(
+    std::vector<transfer_request> const& treqs, platform_table const& pfs,
+    std::vector<std::optional<route_cache_entry>> const& cached) {
+  auto split = route_cache_split{};
+  auto key_idx = std::size_t{0};
+
+  for (auto const& treq : treqs) {
+    auto const& from = pfs.get(treq.transfer_start_);
+
+    auto tres = transfer_result{};
+    tres.from_loc_ = treq.from_loc_.key();
+    tres.profile_ = treq.profile_;
+
+    auto uncached = transfer_request{};
+    uncached.transfer_start_ = treq.transfer_start_;
+    uncached.from_loc_ = treq.from_loc_;
+    uncached.profile_ = treq.profile_;
+
+    for (auto i = std::size_t{0}; i < treq.transfer_targets_.size();
+         ++i, ++key_idx) {
+      auto const& entry = cached[key_idx];
+      auto const& to = pfs.get(treq.transfer_targets_[i]);
+
+      // entries of moved platforms are routed again
+      if (!entry.has_value() || entry->from_ != from.loc_ ||
+          entry->to_ != to.loc_) {
+        uncached.transfer_targets_.emplace_back(treq.transfer_targets_[i]);
+        uncached.to_locs_.emplace_back(treq.to_locs_[i]);
+        continue;
+      }
+
+      if (entry->reached_) {
+        tres.to_locs_.emplace_back(treq.to_locs_[i].key());
+        tres.infos_.emplace_back(entry->info_);
+      }
+    }
+
+    if (!tres.infos_.empty()) {
+      split.cached_.emplace_back(std::move(tres));
+    }
+    if (!uncached.transfer_targets_.empty()) {
+      split.uncached_.emplace_back(std::move(uncached));
+    }
+  }
+
+  return split;
+}
+
+std::vector<std::pair<std::string, route_cache_entry>> to_route_cache_entries(
+    std::vector<transfer_request> const& treqs,
+    std::vector<transfer_result> const& tres,
+    platform_table const& pfs,
+    hash_map<profile_key_t, std::uint64_t> const& profile_hashes) {
+  // reached targets per transfer_result key
+  auto reached =
+      hash_map<std::string, hash_map<location_key_t, transfer_info>>{};
+  for (auto const& tr : tres) {
+    auto& infos = reached[tr.key()];
+    for (auto i = std::size_t{0}; i < tr.to_locs_.size(); ++i) {
+      infos.emplace(tr.to_locs_[i], tr.infos_[i]);
+    }
+  }
+
+  auto entries = std::vector<std::pair<std::string, route_cache_entry>>{};
+  for (auto const& treq : treqs) {
+    auto const& from = pfs.get(treq.transfer_start_);
+    auto const prf_hash = profile_hashes.at(treq.profile_);
+
+    auto tres_key = transfer_result{};
+    tres_key.from_loc_ = treq.from_loc_.key();
+    tres_key.profile_ = treq.profile_;
+    auto const infos = reached.find(tres_key.key());
+
+    for (auto i = std::size_t{0}; i < treq.transfer_targets_.size(); ++i) {
+      auto const& to = pfs.get(treq.transfer_targets_[i]);
+      auto entry = route_cache_entry{from.loc_, to.loc_, false, {}};
+
+      if (infos != end(reached)) {
+        if (auto const it = infos->second.find(treq.to_locs_[i].key());
+            it != end(infos->second)) {
+          entry.reached_ = true;
+          entry.info_ = it->second;
+        }
+      }
+
+      entries.emplace_back(route_cache_key(from, to, prf_hash), entry);
+    }
+  }
+
+  return entries;
+}
+
+std::vector<transfer_result> merge_by_key(
+    std::vector<transfer_result> const& tres) {
+  auto merged = std::vector<transfer_result>{};
+  auto key_to_idx = hash_map<std::string, std::size_t>{};
+
+  for (auto const& tr : tres) {
+    auto const [it, inserted] = key_to_idx.emplace(tr.key(), merged.size());
+    if (inserted) {
+      merged.emplace_back(tr);
+    } else {
+      merged[it->second] = merge(merged[it->second], tr);
+    }
+  }
+
+  return merged;
+}
+
+}  // namespace transfers
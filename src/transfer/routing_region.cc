@@ -0,0 +1,70 @@
+#include "transfers/transfer/routing_region.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace fs = std::filesystem;
+
+namespace transfers {
+
+// approximate length of one degree latitude in meters
+constexpr auto const kMetersPerDegree = 111'320.0;
+
+geo::box get_bounding_box(transfer_request_by_keys_csr const& treqs_k,
+                          platform_table const& pfs) {
+  auto bbox = geo::box{};
+  for (auto const& treq_k : treqs_k) {
+    bbox.extend(pfs.get(pfs.get_idx(treq_k.from_loc_)).loc_);
+    for (auto const to_loc : treq_k.to_locs_) {
+      bbox.extend(pfs.get(pfs.get_idx(to_loc)).loc_);
+    }
+  }
+  return bbox;
+}
+
+geo::box buffer_box(geo::box const& bbox, double const meters) {
+  auto const lat_delta = meters / kMetersPerDegree;
+
+  // longitude degrees are shortest at the latitude closest to a pole
+  auto const max_abs_lat =
+      std::min(std::max(std::abs(bbox.min_.lat_), std::abs(bbox.max_.lat_)),
+               89.0);
+  auto const lng_delta =
+      meters /
+      (kMetersPerDegree * std::cos(max_abs_lat * std::numbers::pi / 180.0));
+
+  auto buffered = bbox;
+  buffered.min_.lat_ = std::max(bbox.min_.lat_ - lat_delta, -90.0);
+  buffered.min_.lng_ = std::max(bbox.min_.lng_ - lng_delta, -180.0);
+  buffered.max_.lat_ = std::min(bbox.max_.lat_ + lat_delta, 90.0);
+  buffered.max_.lng_ = std::min(bbox.max_.lng_ + lng_delta, 180.0);
+  return buffered;
+}
+
+bool contains(geo::box const& outer, geo::box const& inner) {
+  return outer.min_.lat_ <= inner.min_.lat_ &&
+         outer.min_.lng_ <= inner.min_.lng_ &&
+         inner.max_.lat_ <= outer.max_.lat_ &&
+         inner.max_.lng_ <= outer.max_.lng_;
+}
+
+fs::path select_routing_graph(std::vector<routing_graph_tile> const& tiles,
+                              geo::box const& region,
+                              fs::path const& full_graph) {
+  auto const area = [](geo::box const& b) {
+    return (b.max_.lat_ - b.min_.lat_) * (b.max_.lng_ - b.min_.lng_);
+  };
+
+  auto const* best = static_cast<routing_graph_tile const*>(nullptr);
+  for (auto const& tile : tiles) {
+    if (contains(tile.bbox_, region) &&
+        (best == nullptr || area(tile.bbox_) < area(best->bbox_))) {
+      best = &tile;
+    }
+  }
+
+  return best == nullptr ? full_graph : best->path_;
+}
+
+}  // namespace transfers
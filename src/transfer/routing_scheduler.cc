@@ -0,0 +1,192 @@
+#include "transfers/transfer/routing_scheduler.h"
+
+#include <algorithm>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "utl/verify.h"
+
+namespace transfers {
+
+constexpr std::uint64_t pack(std::uint64_t const begin,
+                             std::uint64_t const end) {
+  return begin | (end << 32U);
+}
+
+constexpr std::uint64_t range_begin(std::uint64_t const bounds) {
+  return bounds & 0xFFFF'FFFFU;
+}
+
+constexpr std::uint64_t range_end(std::uint64_t const bounds) {
+  return bounds >> 32U;
+}
+
+work_stealing_scheduler::work_stealing_scheduler(
+    std::vector<std::size_t> order, std::vector<std::size_t> const& range_sizes)
+    : order_(std::move(order)),
+      ranges_(std::max(range_sizes.size(), std::size_t{1U})) {
+  utl::verify(order_.size() < (1ULL << 32U),
+              "work_stealing_scheduler: too many tasks ({})", order_.size());
+  utl::verify(std::accumulate(begin(range_sizes), end(range_sizes),
+                              std::size_t{0U}) == order_.size(),
+              "work_stealing_scheduler: invalid range sizes");
+
+  auto begin = std::uint64_t{0U};
+  for (auto w = std::size_t{0U}; w < range_sizes.size(); ++w) {
+    ranges_[w].bounds_.store(pack(begin, begin + range_sizes[w]));
+    begin += range_sizes[w];
+  }
+
+  set_placement({});
+}
+
+void work_stealing_scheduler::set_placement(thread_placement const& placement) {
+  utl::verify(placement.nodes_.empty() ||
+                  placement.nodes_.size() >= n_workers(),
+              "work_stealing_scheduler: {} threads for {} workers",
+              placement.nodes_.size(), n_workers());
+
+  auto const node = [&](std::size_t const w) {
+    return placement.nodes_.empty() ? 0U : placement.nodes_[w];
+  };
+
+  // victims: next workers (cyclic), same node first
+  victims_.resize(n_workers());
+  for (auto w = std::size_t{0U}; w < n_workers(); ++w) {
+    auto& victims = victims_[w];
+    victims.clear();
+    for (auto i = std::size_t{1U}; i < n_workers(); ++i) {
+      victims.emplace_back((w + i) % n_workers());
+    }
+    std::stable_partition(
+        std::begin(victims), std::end(victims),
+        [&](std::size_t const v) { return node(v) == node(w); });
+  }
+
+  cpus_.assign(
+      std::begin(placement.cpus_),
+      std::begin(placement.cpus_) +
+          static_cast<std::ptrdiff_t>(
+              std::min(placement.cpus_.size(), n_workers())));
+}
+
+std::optional<std::size_t> work_stealing_scheduler::pop(
+    std::size_t const worker) {
+  auto& bounds = ranges_[worker].bounds_;
+  auto current = bounds.load();
+  while (range_begin(current) < range_end(current)) {
+    if (bounds.compare_exchange_weak(
+            current, pack(range_begin(current) + 1U, range_end(current)))) {
+      return order_[range_begin(current)];
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::size_t> work_stealing_scheduler::steal(
+    std::size_t const thief) {
+  for (auto const victim : victims_[thief]) {
+    auto& bounds = ranges_[victim].bounds_;
+    auto current = bounds.load();
+    while (range_begin(current) < range_end(current)) {
+      if (bounds.compare_exchange_weak(
+              current, pack(range_begin(current), range_end(current) - 1U))) {
+        return order_[range_end(current) - 1U];
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+void work_stealing_scheduler::run(
+    std::function<void(std::size_t, std::size_t)> const& fn) {
+  auto errors = std::vector<std::exception_ptr>(ranges_.size());
+
+  auto const work = [&](std::size_t const worker) {
+    if (worker < cpus_.size()) {
+      bind_current_thread(cpus_[worker]);  // best effort
+    }
+
+    try {
+      while (true) {
+        auto task = pop(worker);
+        if (!task.has_value()) {
+          task = steal(worker);
+        }
+        if (!task.has_value()) {
+          break;
+        }
+        fn(worker, *task);
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  };
+
+  auto threads = std::vector<std::thread>{};
+  threads.reserve(ranges_.size());
+  for (auto w = std::size_t{0U}; w < ranges_.size(); ++w) {
+    threads.emplace_back(work, w);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (auto const& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+work_stealing_scheduler make_spatial_scheduler(
+    std::vector<std::uint64_t> const& spatial_keys,
+    std::vector<double> const& costs, std::size_t const n_workers) {
+  utl::verify(spatial_keys.size() == costs.size(),
+              "make_spatial_scheduler: {} spatial keys, {} costs",
+              spatial_keys.size(), costs.size());
+
+  auto const n = std::max(std::min(n_workers, costs.size()), std::size_t{1U});
+
+  auto order = std::vector<std::size_t>(costs.size());
+  std::iota(begin(order), end(order), std::size_t{0U});
+  std::stable_sort(begin(order), end(order),
+                   [&](std::size_t const a, std::size_t const b) {
+                     return spatial_keys[a] < spatial_keys[b];
+                   });
+
+  // split into contiguous chunks: chunk w ends as soon as the accumulated
+  // cost reaches (w + 1) / n of the total cost
+  auto const total_cost =
+      std::accumulate(begin(costs), end(costs), 0.0);
+  auto range_sizes = std::vector<std::size_t>(n);
+  auto acc_cost = 0.0;
+  auto w = std::size_t{0U};
+  for (auto const task_idx : order) {
+    acc_cost += costs[task_idx];
+    ++range_sizes[w];
+    if (w + 1U < n &&
+        acc_cost >= total_cost * static_cast<double>(w + 1U) /
+                        static_cast<double>(n)) {
+      ++w;
+    }
+  }
+
+  // largest first within every chunk: the owner starts with the expensive
+  // tasks of its region, cheap tasks remain at the end for thieves
+  auto chunk_begin = begin(order);
+  for (auto const size : range_sizes) {
+    auto const chunk_end = chunk_begin + static_cast<std::ptrdiff_t>(size);
+    std::stable_sort(chunk_begin, chunk_end,
+                     [&](std::size_t const a, std::size_t const b) {
+                       return costs[a] > costs[b];
+                     });
+    chunk_begin = chunk_end;
+  }
+
+  return work_stealing_scheduler{std::move(order), range_sizes};
+}
+
+}  // namespace transfers
@@ -0,0 +1,247 @@
+#include "transfers/transfer/routing_shard.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <string_view>
+
+#include "transfers/platform/hilbert.h"
+#include "transfers/transfer/profiles.h"
+
+#include "cista/hash.h"
+#include "cista/serialization.h"
+
+#include "fmt/core.h"
+
+#include "utl/to_vec.h"
+#include "utl/verify.h"
+
+namespace fs = std::filesystem;
+namespace pr = ::ppr::routing;
+
+namespace transfers {
+
+std::vector<routing_shard> make_routing_shards(
+    transfer_request_by_keys_csr const& treqs_k,
+    hash_map<location_key_t, platform> const& matches,
+    hash_map<profile_key_t, string_t> const& profile_names,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric, std::size_t const n_shards) {
+  auto const n = std::max(std::min(n_shards, treqs_k.size()), std::size_t{1U});
+
+  // spatial order: Hilbert index of the start location
+  auto order = std::vector<std::size_t>(treqs_k.size());
+  std::iota(begin(order), end(order), std::size_t{0U});
+  auto const hilbert = utl::to_vec(order, [&](std::size_t const i) {
+    return hilbert_index(location{treqs_k[i].from_loc_}.to_latlng());
+  });
+  std::stable_sort(begin(order), end(order),
+                   [&](std::size_t const a, std::size_t const b) {
+                     return hilbert[a] < hilbert[b];
+                   });
+
+  auto shards = std::vector<routing_shard>(n);
+  auto shard_locs = std::vector<set<location_key_t>>(n);
+  auto shard_prfs = std::vector<set<profile_key_t>>(n);
+  for (auto& shard : shards) {
+    shard.offsets_.emplace_back(0U);
+  }
+
+  // contiguous ranges: shard s ends as soon as the accumulated number of
+  // targets reaches (s + 1) / n of all targets
+  auto const n_targets = treqs_k.to_locs_.size();
+  auto acc_targets = std::size_t{0U};
+  auto s = std::size_t{0U};
+  for (auto const i : order) {
+    auto const treq_k = treqs_k[i];
+    auto& shard = shards[s];
+
+    shard.from_locs_.emplace_back(treq_k.from_loc_);
+    shard.profiles_.emplace_back(treq_k.profile_);
+    shard_locs[s].insert(treq_k.from_loc_);
+    for (auto const to_loc : treq_k.to_locs_) {
+      shard.to_locs_.emplace_back(to_loc);
+      shard_locs[s].insert(to_loc);
+    }
+    shard.offsets_.emplace_back(shard.to_locs_.size());
+    shard_prfs[s].insert(treq_k.profile_);
+
+    acc_targets += treq_k.to_locs_.size();
+    if (s + 1U < n && acc_targets * n >= n_targets * (s + 1U)) {
+      ++s;
+    }
+  }
+
+  for (auto i = std::size_t{0U}; i < n; ++i) {
+    for (auto const loc_key : shard_locs[i]) {
+      shards[i].locs_.emplace_back(loc_key);
+      shards[i].pfs_.emplace_back(matches.at(loc_key));
+    }
+    for (auto const prf_key : shard_prfs[i]) {
+      shards[i].profile_keys_.emplace_back(prf_key);
+      shards[i].profile_names_.emplace_back(profile_names.at(prf_key));
+      shards[i].profile_hashes_.emplace_back(
+          hash_search_profile(profiles.at(prf_key)));
+      if (symmetric.count(prf_key) != 0U) {
+        shards[i].symmetric_profiles_.emplace_back(prf_key);
+      }
+    }
+
+    // `hash_` is still 0 while the shard is hashed
+    auto const buf = cista::serialize(shards[i]);
+    shards[i].hash_ = cista::hash(std::string_view{
+        reinterpret_cast<char const*>(buf.data()), buf.size()});
+  }
+
+  return shards;
+}
+
+transfer_request_by_keys_csr get_transfer_requests_by_keys(
+    routing_shard const& shard) {
+  auto treqs_k = transfer_request_by_keys_csr{};
+  treqs_k.reserve(shard.from_locs_.size(), shard.to_locs_.size());
+
+  for (auto i = std::size_t{0U}; i < shard.from_locs_.size(); ++i) {
+    treqs_k.emplace_back(
+        shard.from_locs_[i],
+        std::span<location_key_t const>{
+            shard.to_locs_.data() + shard.offsets_[i],
+            shard.to_locs_.data() + shard.offsets_[i + 1U]},
+        shard.profiles_[i]);
+  }
+
+  return treqs_k;
+}
+
+routing_shard_manifest make_routing_shard_manifest(
+    std::vector<routing_shard> const& shards) {
+  auto manifest = routing_shard_manifest{};
+  for (auto const& shard : shards) {
+    manifest.shard_hashes_.emplace_back(shard.hash_);
+  }
+  return manifest;
+}
+
+hash_map<profile_key_t, pr::search_profile> get_search_profiles(
+    routing_shard const& shard,
+    hash_map<std::string, pr::search_profile> const& name_to_profile) {
+  auto profiles = hash_map<profile_key_t, pr::search_profile>{};
+  for (auto i = std::size_t{0U}; i < shard.profile_keys_.size(); ++i) {
+    auto const name = std::string{shard.profile_names_[i].view()};
+    auto const it = name_to_profile.find(name);
+    utl::verify(it != end(name_to_profile), "no search profile for profile {}",
+                name);
+    utl::verify(hash_search_profile(it->second) == shard.profile_hashes_[i],
+                "search profile {} differs from the exported search profile",
+                name);
+    profiles.emplace(shard.profile_keys_[i], it->second);
+  }
+  return profiles;
+}
+
+set<profile_key_t> get_symmetric_profiles(routing_shard const& shard) {
+  auto symmetric = set<profile_key_t>{};
+  for (auto const prf_key : shard.symmetric_profiles_) {
+    symmetric.insert(prf_key);
+  }
+  return symmetric;
+}
+
+platform_table get_platform_table(routing_shard const& shard) {
+  auto pfs = platform_table{};
+  for (auto i = std::size_t{0U}; i < shard.locs_.size(); ++i) {
+    pfs.add(shard.locs_[i], shard.pfs_[i]);
+  }
+  return pfs;
+}
+
+bool is_result_of(routing_shard_result const& result,
+                  routing_shard const& shard) {
+  return result.shard_hash_ == shard.hash_;
+}
+
+void remove_routing_shard_files(fs::path const& dir) {
+  if (!fs::exists(dir)) {
+    return;
+  }
+
+  auto stale = std::vector<fs::path>{};
+  for (auto const& entry : fs::directory_iterator{dir}) {
+    auto const name = entry.path().filename().string();
+    if (entry.is_regular_file() && name.starts_with("shard_") &&
+        (name.ends_with(".bin") || name.ends_with(".tmp"))) {
+      stale.emplace_back(entry.path());
+    }
+  }
+  for (auto const& path : stale) {
+    fs::remove(path);
+  }
+}
+
+fs::path routing_shard_manifest_path(fs::path const& dir) {
+  return dir / "shard_manifest.bin";
+}
+
+fs::path routing_shard_path(fs::path const& dir, std::size_t const i) {
+  return dir / fmt::format("shard_{}.bin", i);
+}
+
+fs::path routing_shard_result_path(fs::path const& dir, std::size_t const i) {
+  return dir / fmt::format("shard_{}.result.bin", i);
+}
+
+// Writes the given bytes to the given file.
+void write_file(fs::path const& path, cista::byte_buf const& buf) {
+  auto out = std::ofstream{path, std::ios::binary};
+  utl::verify(out.good(), "cannot open {} for writing", path.string());
+  out.write(reinterpret_cast<char const*>(buf.data()),
+            static_cast<std::streamsize>(buf.size()));
+  utl::verify(out.good(), "cannot write {}", path.string());
+}
+
+// Returns the content of the given file.
+std::string read_file(fs::path const& path) {
+  auto in = std::ifstream{path, std::ios::binary};
+  utl::verify(in.good(), "cannot open {} for reading", path.string());
+  return std::string{std::istreambuf_iterator<char>{in},
+                     std::istreambuf_iterator<char>{}};
+}
+
+void write_routing_shard_manifest(fs::path const& path,
+                                  routing_shard_manifest const& manifest) {
+  write_file(path, cista::serialize(manifest));
+}
+
+routing_shard_manifest read_routing_shard_manifest(fs::path const& path) {
+  auto const buf = read_file(path);
+  return cista::copy_from_potentially_unaligned<routing_shard_manifest>(
+      std::string_view{buf});
+}
+
+void write_routing_shard(fs::path const& path, routing_shard const& shard) {
+  write_file(path, cista::serialize(shard));
+}
+
+routing_shard read_routing_shard(fs::path const& path) {
+  auto const buf = read_file(path);
+  return cista::copy_from_potentially_unaligned<routing_shard>(
+      std::string_view{buf});
+}
+
+void write_routing_shard_result(fs::path const& path,
+                                routing_shard_result const& result) {
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+  write_file(tmp_path, cista::serialize(result));
+  fs::rename(tmp_path, path);
+}
+
+routing_shard_result read_routing_shard_result(fs::path const& path) {
+  auto const buf = read_file(path);
+  return cista::copy_from_potentially_unaligned<routing_shard_result>(
+      std::string_view{buf});
+}
+
+}  // namespace transfers
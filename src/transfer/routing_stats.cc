@@ -0,0 +1,154 @@
+#include "transfers/transfer/routing_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "fmt/core.h"
+
+#include "utl/verify.h"
+
+namespace fs = std::filesystem;
+
+namespace transfers {
+
+std::size_t get_latency_bucket(std::uint64_t const duration_us) {
+  auto const ms = duration_us / 1'000U;
+  return std::min(static_cast<std::size_t>(std::bit_width(ms)),
+                  kLatencyBuckets - 1U);
+}
+
+routing_stats_summary summarize_routing_stats(
+    std::vector<routing_query_stats> const& queries,
+    std::size_t const n_slowest,
+    hash_map<profile_key_t, profile_key_t> const& canonical) {
+  auto summary = routing_stats_summary{};
+
+  auto profile_idx = hash_map<profile_key_t, std::size_t>{};
+  for (auto const& q : queries) {
+    auto const [it, added] =
+        profile_idx.emplace(q.profile_, summary.profiles_.size());
+    if (added) {
+      summary.profiles_.emplace_back().profile_ = q.profile_;
+    }
+
+    auto& prf = summary.profiles_[it->second];
+    ++prf.n_queries_;
+    prf.n_targets_ += q.n_targets_;
+    prf.n_reached_ += q.n_reached_;
+    prf.total_us_ += q.duration_us_;
+    prf.max_us_ = std::max(prf.max_us_, q.duration_us_);
+    ++prf.histogram_[get_latency_bucket(q.duration_us_)];
+  }
+
+  std::sort(begin(summary.profiles_), end(summary.profiles_),
+            [](profile_latency const& a, profile_latency const& b) {
+              return a.profile_ < b.profile_;
+            });
+
+  for (auto& prf : summary.profiles_) {
+    prf.aliases_.emplace_back(prf.profile_);
+  }
+  for (auto const& [prf_key, canonical_key] : canonical) {
+    auto const it = std::lower_bound(
+        begin(summary.profiles_), end(summary.profiles_), canonical_key,
+        [](profile_latency const& prf, profile_key_t const key) {
+          return prf.profile_ < key;
+        });
+    if (prf_key == canonical_key || it == end(summary.profiles_) ||
+        it->profile_ != canonical_key) {
+      continue;
+    }
+    it->aliases_.insert(
+        std::upper_bound(begin(it->aliases_), end(it->aliases_), prf_key),
+        prf_key);
+  }
+
+  auto const by_duration = [](routing_query_stats const& a,
+                              routing_query_stats const& b) {
+    return a.duration_us_ > b.duration_us_;
+  };
+  summary.slowest_.resize(std::min(n_slowest, queries.size()));
+  std::partial_sort_copy(begin(queries), end(queries),
+                         begin(summary.slowest_), end(summary.slowest_),
+                         by_duration);
+
+  return summary;
+}
+
+// Returns the given string as quoted and escaped JSON string.
+std::string to_json_string(std::string_view const str) {
+  auto json = std::string{"\""};
+  for (auto const c : str) {
+    switch (c) {
+      case '"': json += "\\\""; break;
+      case '\\': json += "\\\\"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20U) {
+          json += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+          json += c;
+        }
+    }
+  }
+  json += '"';
+  return json;
+}
+
+void write_routing_stats(fs::path const& path,
+                         routing_stats_summary const& summary,
+                         platform_table const& pfs,
+                         hash_map<profile_key_t, string_t> const& names) {
+  auto const profile_name = [&](profile_key_t const prf_key) {
+    auto const it = names.find(prf_key);
+    return it == end(names) ? to_json_string(std::to_string(prf_key))
+                            : to_json_string(it->second.view());
+  };
+
+  auto out = std::ofstream{path};
+  utl::verify(out.good(), "cannot open routing stats file {}", path.string());
+
+  out << "{\n  \"histogram_buckets_ms\": [";
+  for (auto i = std::size_t{1U}; i < kLatencyBuckets; ++i) {
+    out << (i == 1U ? "" : ", ") << (std::uint64_t{1U} << (i - 1U));
+  }
+  out << "],\n  \"profiles\": [";
+
+  for (auto i = std::size_t{0U}; i < summary.profiles_.size(); ++i) {
+    auto const& prf = summary.profiles_[i];
+    out << (i == 0U ? "\n" : ",\n")
+        << fmt::format("    {{\"profile\": {}, \"aliases\": [",
+                       profile_name(prf.profile_));
+    for (auto a = std::size_t{0U}; a < prf.aliases_.size(); ++a) {
+      out << (a == 0U ? "" : ", ") << profile_name(prf.aliases_[a]);
+    }
+    out << fmt::format(
+        "], \"queries\": {}, \"targets\": {}, \"reached\": {}, "
+        "\"total_us\": {}, \"max_us\": {}, \"histogram\": [",
+        prf.n_queries_, prf.n_targets_, prf.n_reached_, prf.total_us_,
+        prf.max_us_);
+    for (auto b = std::size_t{0U}; b < kLatencyBuckets; ++b) {
+      out << (b == 0U ? "" : ", ") << prf.histogram_[b];
+    }
+    out << "]}";
+  }
+  out << "\n  ],\n  \"slowest\": [";
+
+  for (auto i = std::size_t{0U}; i < summary.slowest_.size(); ++i) {
+    auto const& q = summary.slowest_[i];
+    auto const& pf = pfs.get(q.start_);
+    out << (i == 0U ? "\n" : ",\n")
+        << fmt::format(
+               "    {{\"start\": \"{}{}\", \"lat\": {}, \"lng\": {}, "
+               "\"profile\": {}, \"duration_us\": {}, \"targets\": {}, "
+               "\"reached\": {}}}",
+               get_osm_type_as_char(pf.osm_type_), pf.osm_id_, pf.loc_.lat_,
+               pf.loc_.lng_, profile_name(q.profile_), q.duration_us_,
+               q.n_targets_, q.n_reached_);
+  }
+  out << "\n  ]\n}\n";
+}
+
+}  // namespace transfers
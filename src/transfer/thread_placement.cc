@@ -0,0 +1,176 @@
+#include "transfers/transfer/thread_placement.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "utl/verify.h"
+
+namespace fs = std::filesystem;
+
+namespace transfers {
+
+std::size_t cpu_topology::n_cpus() const {
+  auto n = std::size_t{0U};
+  for (auto const& cpus : nodes_) {
+    n += cpus.size();
+  }
+  return n;
+}
+
+std::size_t thread_placement::n_threads() const {
+  return nodes_.empty()
+             ? std::max(std::thread::hardware_concurrency(), 1U)
+             : nodes_.size();
+}
+
+// Parses a single CPU number of a CPU list.
+unsigned parse_cpu(std::string_view const str) {
+  auto cpu = 0U;
+  auto const [ptr, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), cpu);
+  utl::verify(ec == std::errc{} && ptr == str.data() + str.size(),
+              "invalid cpu list entry: {}", str);
+  return cpu;
+}
+
+std::vector<unsigned> parse_cpu_list(std::string_view list) {
+  while (!list.empty() && std::isspace(list.back()) != 0) {
+    list.remove_suffix(1U);
+  }
+
+  auto cpus = std::vector<unsigned>{};
+  while (!list.empty()) {
+    auto const comma = list.find(',');
+    auto const entry = list.substr(0U, comma);
+    list = comma == std::string_view::npos ? std::string_view{}
+                                           : list.substr(comma + 1U);
+
+    if (auto const dash = entry.find('-'); dash != std::string_view::npos) {
+      auto const first = parse_cpu(entry.substr(0U, dash));
+      auto const last = parse_cpu(entry.substr(dash + 1U));
+      for (auto cpu = first; cpu <= last; ++cpu) {
+        cpus.emplace_back(cpu);
+      }
+    } else if (!entry.empty()) {
+      cpus.emplace_back(parse_cpu(entry));
+    }
+  }
+  return cpus;
+}
+
+cpu_topology get_cpu_topology() {
+  auto topology = cpu_topology{};
+
+#if defined(__linux__)
+  // only CPUs in the affinity mask of the process (e.g. container limits)
+  auto allowed = cpu_set_t{};
+  CPU_ZERO(&allowed);
+  auto const has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+  auto const node_dir = fs::path{"/sys/devices/system/node"};
+  auto ec = std::error_code{};
+  auto node_ids = std::vector<unsigned>{};
+  for (auto const& entry : fs::directory_iterator{node_dir, ec}) {
+    auto const name = entry.path().filename().string();
+    if (name.size() > 4U && name.starts_with("node") &&
+        std::all_of(begin(name) + 4, end(name),
+                    [](char const c) { return std::isdigit(c) != 0; })) {
+      node_ids.emplace_back(parse_cpu(std::string_view{name}.substr(4U)));
+    }
+  }
+  std::sort(begin(node_ids), end(node_ids));
+
+  for (auto const node_id : node_ids) {
+    auto in = std::ifstream{node_dir / ("node" + std::to_string(node_id)) /
+                            "cpulist"};
+    auto list = std::string{};
+    std::getline(in, list);
+
+    auto cpus = parse_cpu_list(list);
+    if (has_mask) {
+      std::erase_if(cpus, [&](unsigned const cpu) {
+        return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed);
+      });
+    }
+    if (!cpus.empty()) {
+      topology.nodes_.emplace_back(std::move(cpus));
+    }
+  }
+#endif
+
+  if (topology.nodes_.empty()) {
+    auto& cpus = topology.nodes_.emplace_back();
+    for (auto cpu = 0U; cpu < std::max(std::thread::hardware_concurrency(), 1U);
+         ++cpu) {
+      cpus.emplace_back(cpu);
+    }
+  }
+
+  return topology;
+}
+
+thread_placement make_thread_placement(routing_thread_config const& config,
+                                       cpu_topology const& topology) {
+  if (config.n_threads_ == 0U && !config.pin_threads_ && !config.numa_aware_) {
+    return {};
+  }
+
+  // all CPUs, node by node
+  auto cpus = std::vector<unsigned>{};
+  auto cpu_nodes = std::vector<std::size_t>{};
+  for (auto node = std::size_t{0U}; node < topology.nodes_.size(); ++node) {
+    for (auto const cpu : topology.nodes_[node]) {
+      cpus.emplace_back(cpu);
+      cpu_nodes.emplace_back(node);
+    }
+  }
+  utl::verify(!cpus.empty(), "make_thread_placement: no cpus available");
+
+  auto const n_threads =
+      config.n_threads_ == 0U ? cpus.size() : config.n_threads_;
+
+  auto placement = thread_placement{};
+  for (auto i = std::size_t{0U}; i < n_threads; ++i) {
+    auto const node = cpu_nodes[i % cpus.size()];
+    placement.nodes_.emplace_back(config.numa_aware_ ? node : 0U);
+    if (config.pin_threads_) {
+      placement.cpus_.emplace_back(std::vector{cpus[i % cpus.size()]});
+    } else if (config.numa_aware_) {
+      // memory is allocated on the node of the CPU the thread runs on: keep
+      // the thread on its node
+      placement.cpus_.emplace_back(topology.nodes_[node]);
+    }
+  }
+  return placement;
+}
+
+bool bind_current_thread(std::vector<unsigned> const& cpus) {
+#if defined(__linux__)
+  auto set = cpu_set_t{};
+  CPU_ZERO(&set);
+  for (auto const cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  return !cpus.empty() &&
+         pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+}  // namespace transfers
@@ -1,13 +1,22 @@
 #include "transfers/transfer/transfer_request.h"
 
 #include <cstring>
+#include <algorithm>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include "transfers/transfer/profiles.h"
 #include "transfers/types.h"
 
+#include "cista/hash.h"
+
 #include "fmt/core.h"
 
+#include "utl/parallel_for.h"
 #include "utl/progress_tracker.h"
+#include "utl/to_vec.h"
 #include "utl/verify.h"
 
 namespace transfers {
@@ -23,6 +32,96 @@ std::string transfer_request_by_keys::key() const {
   return key;
 }
 
+std::string transfer_request_by_keys_view::key() const {
+  auto key = std::string{};
+
+  // transfer_request_by_keys key: from location key + profile key
+  key.resize(sizeof(from_loc_) + sizeof(profile_));
+  std::memcpy(key.data(), &from_loc_, sizeof(from_loc_));
+  std::memcpy(key.data() + sizeof(from_loc_), &profile_, sizeof(profile_));
+
+  return key;
+}
+
+transfer_request_by_keys
+transfer_request_by_keys_view::to_transfer_request_by_keys() const {
+  auto treq_k = transfer_request_by_keys{};
+
+  treq_k.from_loc_ = from_loc_;
+  treq_k.profile_ = profile_;
+  treq_k.to_locs_.reserve(to_locs_.size());
+  for (auto const to_loc : to_locs_) {
+    treq_k.to_locs_.emplace_back(to_loc);
+  }
+
+  return treq_k;
+}
+
+void transfer_request_by_keys_csr::emplace_back(
+    location_key_t const from_loc, std::span<location_key_t const> to_locs,
+    profile_key_t const profile) {
+  from_locs_.emplace_back(from_loc);
+  profiles_.emplace_back(profile);
+  to_locs_.insert(to_locs_.end(), to_locs.begin(), to_locs.end());
+  offsets_.emplace_back(to_locs_.size());
+}
+
+void transfer_request_by_keys_csr::emplace_back(
+    transfer_request_by_keys_view const& treq_k) {
+  emplace_back(treq_k.from_loc_, treq_k.to_locs_, treq_k.profile_);
+}
+
+void transfer_request_by_keys_csr::emplace_back(
+    transfer_request_by_keys const& treq_k) {
+  emplace_back(treq_k.from_loc_,
+               std::span<location_key_t const>{treq_k.to_locs_.data(),
+                                               treq_k.to_locs_.size()},
+               treq_k.profile_);
+}
+
+void transfer_request_by_keys_csr::append(
+    transfer_request_by_keys_csr const& other) {
+  auto const offset = to_locs_.size();
+
+  from_locs_.insert(from_locs_.end(), other.from_locs_.begin(),
+                    other.from_locs_.end());
+  profiles_.insert(profiles_.end(), other.profiles_.begin(),
+                   other.profiles_.end());
+  to_locs_.insert(to_locs_.end(), other.to_locs_.begin(), other.to_locs_.end());
+  for (auto i = std::size_t{1U}; i < other.offsets_.size(); ++i) {
+    offsets_.emplace_back(offset + other.offsets_[i]);
+  }
+}
+
+void transfer_request_by_keys_csr::reserve(std::size_t const n_requests,
+                                           std::size_t const n_to_locs) {
+  from_locs_.reserve(n_requests);
+  profiles_.reserve(n_requests);
+  offsets_.reserve(n_requests + 1);
+  to_locs_.reserve(n_to_locs);
+}
+
+void transfer_request_by_keys_csr::clear() {
+  from_locs_.clear();
+  profiles_.clear();
+  offsets_.assign(1U, 0U);
+  to_locs_.clear();
+}
+
+std::uint64_t transfer_request_by_keys_csr::hash() const {
+  auto const bytes = [](auto const& v) {
+    return std::string_view{reinterpret_cast<char const*>(v.data()),
+                            v.size() * sizeof(v.front())};
+  };
+
+  auto h = cista::BASE_HASH;
+  h = cista::hash(bytes(from_locs_), h);
+  h = cista::hash(bytes(profiles_), h);
+  h = cista::hash(bytes(offsets_), h);
+  h = cista::hash(bytes(to_locs_), h);
+  return h;
+}
+
 std::string transfer_request::key() const {
   auto key = std::string{};
 
@@ -35,112 +134,317 @@ std::string transfer_request::key() const {
 }
 
 std::vector<transfer_request> to_transfer_requests(
-    std::vector<transfer_request_by_keys> const& treqs_k,
-    hash_map<location_key_t, platform> const& matches) {
+    transfer_request_by_keys_csr const& treqs_k, platform_table const& pfs) {
+  return to_transfer_requests(treqs_k, pfs, 0U, treqs_k.size());
+}
+
+std::vector<transfer_request> to_transfer_requests(
+    transfer_request_by_keys_csr const& treqs_k, platform_table const& pfs,
+    std::size_t const first, std::size_t const last) {
   auto treqs = std::vector<transfer_request>{};
+  treqs.reserve(last - first);
 
-  for (auto const& treq_k : treqs_k) {
+  for (auto i = first; i < last; ++i) {
+    auto const treq_k = treqs_k[i];
     auto treq = transfer_request{};
 
     treq.from_loc_ = location(treq_k.from_loc_);
     treq.profile_ = treq_k.profile_;
 
     // extract from_pf
-    treq.transfer_start_ = matches.at(treq_k.from_loc_);
+    treq.transfer_start_ = pfs.get_idx(treq_k.from_loc_);
 
     // extract to_pfs
+    treq.transfer_targets_.reserve(treq_k.to_locs_.size());
+    treq.to_locs_.reserve(treq_k.to_locs_.size());
     for (auto to_loc_key : treq_k.to_locs_) {
-      treq.transfer_targets_.emplace_back(matches.at(to_loc_key));
+      treq.transfer_targets_.emplace_back(pfs.get_idx(to_loc_key));
       treq.to_locs_.emplace_back(to_loc_key);
     }
 
-    treqs.emplace_back(treq);
+    treqs.emplace_back(std::move(treq));
   }
 
   return treqs;
 }
 
-std::vector<transfer_request_by_keys>
-generate_all_pair_transfer_requests_by_keys(
-    transfer_request_generation_data const& data,
-    transfer_request_options const& opts) {
-  auto result = std::vector<transfer_request_by_keys>{};
-  auto const profiles = data.profile_key_to_search_profile_;
+// Returns the indices of the given matched locations grouped by their matched
+// platform. Locations matched to the same platform (e.g. stop points of one
+// station) share their transfer targets.
+std::vector<std::vector<std::size_t>> group_by_platform(
+    transfer_request_generation_data::matched_nigiri_location_data const&
+        locs) {
+  auto groups = std::vector<std::vector<std::size_t>>{};
+  auto pf_to_group = hash_map<std::string, std::size_t>{};
+
+  for (auto i = std::size_t{0}; i < locs.matched_pfs_idx_.size(); ++i) {
+    auto const [it, inserted] = pf_to_group.emplace(
+        locs.matched_pfs_idx_.get_platform(i).key(), groups.size());
+    if (inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].emplace_back(i);
+  }
 
-  auto const all_pairs_trs =
-      [&profiles](
-          transfer_request_generation_data::matched_nigiri_location_data const&
-              from,
-          transfer_request_generation_data::matched_nigiri_location_data const&
-              to,
-          profile_key_t const& prf_key) {
-        auto from_to_trs = std::vector<transfer_request_by_keys>{};
-        auto const& profile = profiles.at(prf_key);
-        auto prf_dist = profile.walking_speed_ * profile.duration_limit_;
+  return groups;
+}
 
-        if (from.matched_pfs_idx_.size() == 0 ||
-            to.matched_pfs_idx_.size() == 0) {
-          return from_to_trs;
-        }
+// Appends one `transfer_request_by_keys` per profile and location of
+// `from_loc_keys` to `trs`. The targets of a profile are the prefix of the
+// distance sorted `targets` ((distance, location key) tuples) that lies within
+// the radius (max distance) of the profile.
+void add_trs(transfer_request_by_keys_csr& trs,
+             std::vector<location_key_t> const& from_loc_keys,
+             std::vector<std::pair<double, location_key_t>> const& targets,
+             std::vector<std::pair<profile_key_t, double>> const& prf_dists) {
+  auto to_loc_keys = std::vector<location_key_t>{};
+
+  for (auto const& [prf_key, prf_dist] : prf_dists) {
+    auto const targets_end = std::upper_bound(
+        begin(targets), end(targets), prf_dist,
+        [](double const dist, std::pair<double, location_key_t> const& t) {
+          return dist < t.first;
+        });
+
+    if (targets_end == begin(targets)) {
+      continue;
+    }
 
-        for (auto i = std::size_t{0}; i < from.matched_pfs_idx_.size(); ++i) {
+    to_loc_keys.clear();
+    for (auto t = begin(targets); t != targets_end; ++t) {
+      to_loc_keys.emplace_back(t->second);
+    }
 
-          auto from_pf = from.matched_pfs_idx_.get_platform(i);
-          auto target_ids = to.matched_pfs_idx_.get_other_platforms_in_radius(
-              from_pf, prf_dist);
-          auto from_loc_key = from.locs_[i].key();
+    for (auto const from_loc_key : from_loc_keys) {
+      trs.emplace_back(from_loc_key, to_loc_keys, prf_key);
+    }
+  }
+}
 
-          if (target_ids.empty()) {
-            continue;
-          }
+// Returns the distance sorted list of (distance, location key) tuples of all
+// locations of `to` within `max_dist` meters around the given platform.
+std::vector<std::pair<double, location_key_t>> get_targets(
+    platform const& from_pf,
+    transfer_request_generation_data::matched_nigiri_location_data const& to,
+    double const max_dist) {
+  if (to.matched_pfs_idx_.size() == 0) {
+    return {};
+  }
 
-          auto tmp = transfer_request_by_keys{};
-          auto to_loc_keys = vector<location_key_t>{};
+  return utl::to_vec(
+      to.matched_pfs_idx_.get_other_platforms_in_radius_with_distance_info(
+          from_pf, max_dist),
+      [&](std::pair<double, std::size_t> const& t) {
+        return std::pair<double, location_key_t>{t.first,
+                                                 to.locs_[t.second].key()};
+      });
+}
 
-          for (auto t_id : target_ids) {
-            to_loc_keys.emplace_back(to.locs_[t_id].key());
-          }
+// Returns the location keys of all locations of the given platform group.
+std::vector<location_key_t> get_loc_keys(
+    transfer_request_generation_data::matched_nigiri_location_data const& locs,
+    std::vector<std::size_t> const& group) {
+  return utl::to_vec(group,
+                     [&](std::size_t const i) { return locs.locs_[i].key(); });
+}
 
-          tmp.from_loc_ = from_loc_key;
-          tmp.to_locs_ = to_loc_keys;
-          tmp.profile_ = prf_key;
+// Returns the `transfer_request_by_keys` of all given profiles from all
+// locations of the platform groups [first, last) of `from` to the locations of
+// `to`.
+// The index is queried only once per platform group using the largest profile
+// radius; each profile takes the prefix of the distance sorted neighbours.
+transfer_request_by_keys_csr all_pairs_trs(
+    transfer_request_generation_data::matched_nigiri_location_data const& from,
+    std::vector<std::vector<std::size_t>> const& from_groups,
+    std::size_t const first, std::size_t const last,
+    transfer_request_generation_data::matched_nigiri_location_data const& to,
+    std::vector<std::pair<profile_key_t, double>> const& prf_dists,
+    double const max_dist) {
+  auto from_to_trs = transfer_request_by_keys_csr{};
+
+  for (auto g = first; g < last; ++g) {
+    auto const& group = from_groups[g];
+    auto const from_pf = from.matched_pfs_idx_.get_platform(group.front());
+    auto const targets = get_targets(from_pf, to, max_dist);
+
+    if (targets.empty()) {
+      continue;
+    }
 
-          from_to_trs.emplace_back(tmp);
-        }
+    add_trs(from_to_trs, get_loc_keys(from, group), targets, prf_dists);
+  }
 
-        return from_to_trs;
-      };
+  return from_to_trs;
+}
 
-  auto progress_tracker = utl::get_active_progress_tracker();
+// (update -> old) neighbour pair found while generating update requests.
+struct update_old_pair {
+  std::size_t old_idx_;
+  location_key_t update_loc_;
+  double dist_;
+};
+
+// Returns the `transfer_request_by_keys` of all given profiles from all
+// locations of the update platform groups [first, last) to the locations of
+// the old and the update state (2 -> 1, 2 -> 2) in a single pass.
+// Because the neighbour relation is symmetric, every (update, old) neighbour
+// pair is also appended to `pairs`. The reverse requests (1 -> 2) are built
+// from these pairs without querying the update index from old locations.
+transfer_request_by_keys_csr update_trs(
+    transfer_request_generation_data::matched_nigiri_location_data const&
+        update,
+    std::vector<std::vector<std::size_t>> const& update_groups,
+    std::size_t const first, std::size_t const last,
+    transfer_request_generation_data::matched_nigiri_location_data const& old,
+    std::vector<std::pair<profile_key_t, double>> const& prf_dists,
+    double const max_dist, std::vector<update_old_pair>& pairs) {
+  auto trs = transfer_request_by_keys_csr{};
+
+  for (auto g = first; g < last; ++g) {
+    auto const& group = update_groups[g];
+    auto const from_pf = update.matched_pfs_idx_.get_platform(group.front());
+
+    auto old_targets = std::vector<std::pair<double, std::size_t>>{};
+    if (old.matched_pfs_idx_.size() != 0) {
+      old_targets =
+          old.matched_pfs_idx_.get_other_platforms_in_radius_with_distance_info(
+              from_pf, max_dist);
+    }
+    auto const update_targets = get_targets(from_pf, update, max_dist);
+
+    // merge targets in old and update state (both sorted by distance)
+    auto targets = std::vector<std::pair<double, location_key_t>>{};
+    targets.reserve(old_targets.size() + update_targets.size());
+    auto u = begin(update_targets);
+    for (auto const& [dist, old_idx] : old_targets) {
+      for (; u != end(update_targets) && u->first < dist; ++u) {
+        targets.emplace_back(*u);
+      }
+      targets.emplace_back(dist, old.locs_[old_idx].key());
+
+      for (auto const i : group) {
+        pairs.emplace_back(
+            update_old_pair{old_idx, update.locs_[i].key(), dist});
+      }
+    }
+    targets.insert(end(targets), u, end(update_targets));
 
-  // new possible transfers: 1 -> 2, 2 -> 1, 2 -> 2
-  for (auto const& [prf_key, prf_info] : profiles) {
-    if (opts.old_to_old_) {
-      auto trs11 = all_pairs_trs(data.old_, data.old_, prf_key);
-      result.insert(result.end(), trs11.begin(), trs11.end());
+    if (targets.empty()) {
+      continue;
     }
 
+    add_trs(trs, get_loc_keys(update, group), targets, prf_dists);
+  }
+
+  return trs;
+}
+
+transfer_request_by_keys_csr generate_all_pair_transfer_requests_by_keys(
+    transfer_request_generation_data const& data,
+    transfer_request_options const& opts) {
+  // number of platform groups (origins) handled by a single job
+  constexpr auto const kGroupsPerJob = std::size_t{512U};
+
+  struct job {
+    bool is_update_;
+    std::size_t first_, last_;
+  };
+
+  auto const has_update = data.update_.set_matched_pfs_idx_;
+
+  auto prf_dists = std::vector<std::pair<profile_key_t, double>>{};
+  auto max_dist = 0.0;
+  for (auto const& [prf_key, profile] : data.profile_key_to_search_profile_) {
+    prf_dists.emplace_back(prf_key, get_max_distance(profile));
+    max_dist = std::max(max_dist, prf_dists.back().second);
+  }
+
+  auto const old_groups = opts.old_to_old_
+                              ? group_by_platform(data.old_)
+                              : std::vector<std::vector<std::size_t>>{};
+  auto const update_groups = has_update
+                                 ? group_by_platform(data.update_)
+                                 : std::vector<std::vector<std::size_t>>{};
+
+  // split old (1 -> 1) and update (2 -> 1, 2 -> 2) origins into jobs of origin
+  // chunks; job order defines the (deterministic) order of the result
+  auto jobs = std::vector<job>{};
+  auto const add_jobs = [&](bool const is_update, std::size_t const n_groups) {
+    for (auto first = std::size_t{0}; first < n_groups;
+         first += kGroupsPerJob) {
+      jobs.emplace_back(
+          job{is_update, first, std::min(first + kGroupsPerJob, n_groups)});
+    }
+  };
+
+  if (!prf_dists.empty()) {
+    if (opts.old_to_old_ && data.old_.matched_pfs_idx_.size() != 0) {
+      add_jobs(false, old_groups.size());
+    }
+
+    // new possible transfers: 1 -> 2, 2 -> 1, 2 -> 2
+    if (has_update) {
+      add_jobs(true, update_groups.size());
+    }
+  }
+
+  auto progress_tracker = utl::get_active_progress_tracker();
+  progress_tracker->in_high(jobs.size() + 1);
+
+  // every job writes into its own buffers; no synchronization needed
+  auto job_trs = std::vector<transfer_request_by_keys_csr>(jobs.size());
+  auto job_pairs = std::vector<std::vector<update_old_pair>>(jobs.size());
+  utl::parallel_for_run(jobs.size(), [&](std::size_t const i) {
+    auto const& j = jobs[i];
+    if (j.is_update_) {
+      // new transfers from update to old and update (2 -> 1, 2 -> 2)
+      job_trs[i] = update_trs(data.update_, update_groups, j.first_, j.last_,
+                              data.old_, prf_dists, max_dist, job_pairs[i]);
+    } else {
+      job_trs[i] = all_pairs_trs(data.old_, old_groups, j.first_, j.last_,
+                                 data.old_, prf_dists, max_dist);
+    }
     progress_tracker->increment();
+  });
+
+  // new transfers from old to update (1 -> 2): reverse (2 -> 1) pairs
+  auto old_to_update =
+      std::vector<std::vector<std::pair<double, location_key_t>>>(
+          has_update ? data.old_.locs_.size() : 0U);
+  for (auto const& pairs : job_pairs) {
+    for (auto const& p : pairs) {
+      old_to_update[p.old_idx_].emplace_back(p.dist_, p.update_loc_);
+    }
+  }
 
-    if (!data.update_.set_matched_pfs_idx_) {
-      progress_tracker->increment(3);
+  auto trs12 = transfer_request_by_keys_csr{};
+  for (auto old_idx = std::size_t{0}; old_idx < old_to_update.size();
+       ++old_idx) {
+    auto& targets = old_to_update[old_idx];
+    if (targets.empty()) {
       continue;
     }
+    std::stable_sort(begin(targets), end(targets),
+                     [](auto const& a, auto const& b) {
+                       return a.first < b.first;
+                     });
+    add_trs(trs12, {data.old_.locs_[old_idx].key()}, targets, prf_dists);
+  }
+  progress_tracker->increment();
 
-    // new transfers from old to update (1 -> 2)
-    auto trs12 = all_pairs_trs(data.old_, data.update_, prf_key);
-    progress_tracker->increment();
-    // new transfers from update to old (2 -> 1)
-    auto trs21 = all_pairs_trs(data.update_, data.old_, prf_key);
-    progress_tracker->increment();
-    // new transfers from update to update (2 -> 2)
-    auto trs22 = all_pairs_trs(data.update_, data.update_, prf_key);
-    progress_tracker->increment();
+  auto n_requests = trs12.size();
+  auto n_to_locs = trs12.to_locs_.size();
+  for (auto const& trs : job_trs) {
+    n_requests += trs.size();
+    n_to_locs += trs.to_locs_.size();
+  }
 
-    result.insert(result.end(), trs12.begin(), trs12.end());
-    result.insert(result.end(), trs21.begin(), trs21.end());
-    result.insert(result.end(), trs22.begin(), trs22.end());
+  auto result = transfer_request_by_keys_csr{};
+  result.reserve(n_requests, n_to_locs);
+  for (auto const& trs : job_trs) {
+    result.append(trs);
   }
+  result.append(trs12);
 
   return result;
 }
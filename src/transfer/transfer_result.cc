@@ -1,14 +1,18 @@
 #include "transfers/transfer/transfer_result.h"
 
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <utility>
 
-#include "transfers/platform/to_ppr.h"
-
-#include "boost/thread/lock_types.hpp"
-#include "boost/thread/mutex.hpp"
+#include "transfers/platform/hilbert.h"
+#include "transfers/transfer/profiles.h"
+#include "transfers/transfer/routing_scheduler.h"
 
 #include "fmt/core.h"
 
@@ -16,7 +20,6 @@
 #include "ppr/routing/route.h"
 #include "ppr/routing/search.h"
 
-#include "utl/parallel_for.h"
 #include "utl/progress_tracker.h"
 #include "utl/to_vec.h"
 #include "utl/verify.h"
@@ -56,15 +59,17 @@ std::string transfer_result::key() const {
 
 pr::routing_query build_routing_query(
     const hash_map<profile_key_t, pr::search_profile>& profiles,
-    transfer_request const& treq) {
+    platform_table const& pfs, transfer_request const& treq) {
   // query: create start input_location
-  auto const& li_start = to_input_location(treq.transfer_start_);
+  auto const& li_start = pfs.get_input_location(treq.transfer_start_);
 
   // query: create dest input_locations
   std::vector<pr::input_location> ils_dests;
-  std::transform(treq.transfer_targets_.cbegin(), treq.transfer_targets_.cend(),
-                 std::back_inserter(ils_dests),
-                 [](auto const& pf) { return to_input_location(pf); });
+  ils_dests.reserve(treq.transfer_targets_.size());
+  std::transform(
+      treq.transfer_targets_.cbegin(), treq.transfer_targets_.cend(),
+      std::back_inserter(ils_dests),
+      [&pfs](auto const pf_idx) { return pfs.get_input_location(pf_idx); });
 
   // query: get search profile
   auto const& profile = profiles.at(treq.profile_);
@@ -76,13 +81,14 @@ pr::routing_query build_routing_query(
 }
 
 transfer_result route_single_request(
-    transfer_request const& treq, ::ppr::routing_graph const& rg,
+    transfer_request const& treq, platform_table const& pfs,
+    ::ppr::routing_graph const& rg,
     hash_map<profile_key_t, pr::search_profile> const& profiles) {
   auto tres = transfer_result{};
   tres.from_loc_ = treq.from_loc_.key();
   tres.profile_ = treq.profile_;
 
-  auto const& rq = build_routing_query(profiles, treq);
+  auto const& rq = build_routing_query(profiles, pfs, treq);
 
   // route using find_routes_v2
   auto const& search_res = pr::find_routes_v2(rg, rq);
@@ -108,26 +114,503 @@ transfer_result route_single_request(
   return tres;
 }
 
-std::vector<transfer_result> route_multiple_requests(
-    std::vector<transfer_request> const& treqs, ::ppr::routing_graph const& rg,
+// Request access of the routing functions below: expanded `transfer_request`s.
+struct expanded_requests {
+  std::size_t size() const { return treqs_.size(); }
+
+  platform_idx_t start(std::size_t const i) const {
+    return treqs_[i].transfer_start_;
+  }
+
+  location_key_t from_loc(std::size_t const i) const {
+    return treqs_[i].from_loc_.key();
+  }
+
+  profile_key_t profile(std::size_t const i) const {
+    return treqs_[i].profile_;
+  }
+
+  // Calls `fn(target_platform, target_location)` for every target of the
+  // `i`-th request.
+  template <typename Fn>
+  void for_each_target(std::size_t const i, Fn&& fn) const {
+    auto const& treq = treqs_[i];
+    for (auto t = std::size_t{0}; t < treq.transfer_targets_.size(); ++t) {
+      fn(treq.transfer_targets_[t], treq.to_locs_[t].key());
+    }
+  }
+
+  std::vector<transfer_request> const& treqs_;
+};
+
+// Request access of the routing functions below: the key form requests in
+// [first_, first_ + n_) of a CSR container. Platforms are looked up whenever
+// a request is accessed, i.e. requests are expanded on the fly (by the
+// routing worker) instead of being converted up front.
+struct key_form_requests {
+  std::size_t size() const { return n_; }
+
+  platform_idx_t start(std::size_t const i) const {
+    return pfs_.get_idx(from_loc(i));
+  }
+
+  location_key_t from_loc(std::size_t const i) const {
+    return treqs_k_.from_locs_[first_ + i];
+  }
+
+  profile_key_t profile(std::size_t const i) const {
+    return treqs_k_.profiles_[first_ + i];
+  }
+
+  template <typename Fn>
+  void for_each_target(std::size_t const i, Fn&& fn) const {
+    for (auto const to_loc : treqs_k_[first_ + i].to_locs_) {
+      fn(pfs_.get_idx(to_loc), to_loc);
+    }
+  }
+
+  transfer_request_by_keys_csr const& treqs_k_;
+  platform_table const& pfs_;
+  std::size_t first_;
+  std::size_t n_;
+};
+
+// Groups the given requests into routing tasks (see `to_routing_tasks`).
+// Requests are grouped by their canonical profile (see
+// `get_canonical_profiles`; profiles without an entry are their own canonical
+// profile): requests of profiles with equal search parameters are routed with
+// a single search.
+template <typename Requests>
+std::vector<routing_task> build_routing_tasks(
+    Requests const& reqs,
+    hash_map<profile_key_t, profile_key_t> const& canonical) {
+  auto tasks = std::vector<routing_task>{};
+  auto task_indices = hash_map<platform_idx_t, std::size_t>{};
+
+  // targets per task and profile before they are mapped to the task union
+  auto profile_targets_pfs =
+      std::vector<std::vector<std::vector<platform_idx_t>>>{};
+
+  for (auto i = std::size_t{0}; i < reqs.size(); ++i) {
+    auto const start = reqs.start(i);
+    auto const canonical_it = canonical.find(reqs.profile(i));
+    auto const profile = canonical_it == end(canonical) ? reqs.profile(i)
+                                                         : canonical_it->second;
+
+    auto const [it, inserted] = task_indices.emplace(start, tasks.size());
+    if (inserted) {
+      tasks.emplace_back(routing_task{start, {}, {}});
+      profile_targets_pfs.emplace_back();
+    }
+
+    auto& task = tasks[it->second];
+    auto& pf_targets = profile_targets_pfs[it->second];
+    auto prf_it = std::find_if(
+        begin(task.profiles_), end(task.profiles_),
+        [&](profile_targets const& pt) { return pt.profile_ == profile; });
+    if (prf_it == end(task.profiles_)) {
+      task.profiles_.emplace_back(profile_targets{profile, {}, {}, {}, {}});
+      pf_targets.emplace_back();
+      prf_it = std::prev(end(task.profiles_));
+    }
+    auto const prf_idx =
+        static_cast<std::size_t>(std::distance(begin(task.profiles_), prf_it));
+
+    reqs.for_each_target(i, [&](platform_idx_t const pf_idx, location_key_t) {
+      task.targets_.emplace_back(pf_idx);
+      pf_targets[prf_idx].emplace_back(pf_idx);
+    });
+    prf_it->treqs_.emplace_back(i);
+  }
+
+  auto const sort_unique = [](std::vector<platform_idx_t>& v) {
+    std::sort(begin(v), end(v));
+    v.erase(std::unique(begin(v), end(v)), end(v));
+  };
+
+  for (auto t = std::size_t{0}; t < tasks.size(); ++t) {
+    auto& task = tasks[t];
+    sort_unique(task.targets_);
+
+    for (auto p = std::size_t{0}; p < task.profiles_.size(); ++p) {
+      auto& pf_targets = profile_targets_pfs[t][p];
+      sort_unique(pf_targets);
+      task.profiles_[p].targets_ =
+          utl::to_vec(pf_targets, [&](platform_idx_t const pf_idx) {
+            return static_cast<std::uint32_t>(
+                std::lower_bound(begin(task.targets_), end(task.targets_),
+                                 pf_idx) -
+                begin(task.targets_));
+          });
+    }
+  }
+
+  return tasks;
+}
+
+std::vector<routing_task> to_routing_tasks(
+    std::vector<transfer_request> const& treqs) {
+  return build_routing_tasks(expanded_requests{treqs}, {});
+}
+
+std::size_t prune_symmetric_pairs(std::vector<routing_task>& tasks,
+                                  set<profile_key_t> const& symmetric) {
+  if (symmetric.empty()) {
+    return 0U;
+  }
+
+  auto task_indices = hash_map<platform_idx_t, std::size_t>{};
+  for (auto t = std::size_t{0}; t < tasks.size(); ++t) {
+    task_indices.emplace(tasks[t].start_, t);
+  }
+
+  auto n_mirrored = std::size_t{0};
+  for (auto& task : tasks) {
+    for (auto& prf : task.profiles_) {
+      if (symmetric.count(prf.profile_) == 0) {
+        continue;
+      }
+
+      for (auto const j : prf.targets_) {
+        // every pair is handled once: from the smaller platform index
+        auto const target = task.targets_[j];
+        if (target <= task.start_) {
+          continue;
+        }
+
+        // reverse pair: task of the target with the same profile
+        auto const rev_task_it = task_indices.find(target);
+        if (rev_task_it == end(task_indices)) {
+          continue;
+        }
+        auto& rev_task = tasks[rev_task_it->second];
+        auto const rev_prf =
+            std::find_if(begin(rev_task.profiles_), end(rev_task.profiles_),
+                         [&](profile_targets const& pt) {
+                           return pt.profile_ == prf.profile_;
+                         });
+        if (rev_prf == end(rev_task.profiles_)) {
+          continue;
+        }
+
+        // reverse pair: start platform is a target of the reverse task
+        auto const start_it = std::lower_bound(
+            begin(rev_task.targets_), end(rev_task.targets_), task.start_);
+        if (start_it == end(rev_task.targets_) || *start_it != task.start_) {
+          continue;
+        }
+        auto const rev_j = static_cast<std::uint32_t>(
+            std::distance(begin(rev_task.targets_), start_it));
+        if (!std::binary_search(begin(rev_prf->targets_),
+                                end(rev_prf->targets_), rev_j)) {
+          continue;
+        }
+
+        prf.mirror_out_.emplace_back(j, n_mirrored);
+        rev_prf->mirror_in_.emplace_back(rev_j, n_mirrored);
+        ++n_mirrored;
+      }
+    }
+  }
+
+  // do not route mirrored targets
+  for (auto& task : tasks) {
+    for (auto& prf : task.profiles_) {
+      if (prf.mirror_in_.empty()) {
+        continue;
+      }
+
+      std::sort(begin(prf.mirror_in_), end(prf.mirror_in_));
+      prf.targets_.erase(
+          std::remove_if(begin(prf.targets_), end(prf.targets_),
+                         [&](std::uint32_t const j) {
+                           auto const it = std::lower_bound(
+                               begin(prf.mirror_in_), end(prf.mirror_in_),
+                               std::pair{j, std::size_t{0}});
+                           return it != end(prf.mirror_in_) && it->first == j;
+                         }),
+          end(prf.targets_));
+    }
+  }
+
+  return n_mirrored;
+}
+
+void route_routing_task(
+    routing_task const& task, platform_table const& pfs, router_t const& router,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    routing_scratch& scratch) {
+  auto& infos = scratch.infos_;
+  infos.resize(task.profiles_.size());
+  for (auto& prf_infos : infos) {
+    prf_infos.assign(task.targets_.size(), std::nullopt);
+  }
+
+  // input locations: built once per platform by the platform table
+  auto const& start = pfs.get_input_location(task.start_);
+
+  for (auto p = std::size_t{0}; p < task.profiles_.size(); ++p) {
+    auto const& prf = task.profiles_[p];
+    if (prf.targets_.empty()) {
+      continue;  // all targets mirrored
+    }
+
+    scratch.destinations_.clear();
+    for (auto const i : prf.targets_) {
+      scratch.destinations_.emplace_back(
+          pfs.get_input_location(task.targets_[i]));
+    }
+
+    // the query borrows the destination buffer and returns it afterwards
+    auto rq = pr::routing_query{start, std::move(scratch.destinations_),
+                                profiles.at(prf.profile_),
+                                pr::search_direction::FWD};
+
+    auto const search_start = std::chrono::steady_clock::now();
+    auto const search_res = router(rq);
+    scratch.destinations_ = std::move(rq.destinations_);
+
+    if (scratch.record_stats_) {
+      scratch.stats_.emplace_back(routing_query_stats{
+          .start_ = task.start_,
+          .profile_ = prf.profile_,
+          .duration_us_ = static_cast<std::uint64_t>(
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - search_start)
+                  .count()),
+          .n_targets_ = static_cast<std::uint32_t>(prf.targets_.size()),
+          .n_reached_ =
+              static_cast<std::uint32_t>(search_res.destinations_reached())});
+    }
+
+    if (search_res.destinations_reached() == 0) {
+      continue;
+    }
+
+    assert(search_res.routes_.size() == prf.targets_.size());
+    for (auto i = std::size_t{0}; i < prf.targets_.size(); ++i) {
+      auto const& routes = search_res.routes_[i];
+      if (!routes.empty()) {
+        infos[p][prf.targets_[i]] = transfer_info{
+            get_duration(routes.front()), routes.front().distance_};
+      }
+    }
+  }
+}
+
+double estimate_routing_cost(
+    routing_task const& task,
     hash_map<profile_key_t, pr::search_profile> const& profiles) {
-  auto result = std::vector<transfer_result>{};
+  auto cost = 0.0;
+  for (auto const& prf : task.profiles_) {
+    cost += static_cast<double>(prf.targets_.size()) *
+            get_max_distance(profiles.at(prf.profile_));
+  }
+  return cost;
+}
+
+// Writes the `transfer_result`s of all `transfer_request`s covered by the
+// given `routing_task` to their position in `result` (same index as the
+// request), using the `transfer_info`s computed for the task targets.
+template <typename Requests>
+void expand_routing_task(
+    routing_task const& task,
+    std::vector<std::vector<std::optional<transfer_info>>> const& infos,
+    Requests const& reqs, std::vector<transfer_result>& result) {
+  for (auto p = std::size_t{0}; p < task.profiles_.size(); ++p) {
+    for (auto const treq_idx : task.profiles_[p].treqs_) {
+      auto& tres = result[treq_idx];
+
+      tres.from_loc_ = reqs.from_loc(treq_idx);
+      tres.profile_ = reqs.profile(treq_idx);
+
+      reqs.for_each_target(treq_idx, [&](platform_idx_t const pf_idx,
+                                         location_key_t const to_loc) {
+        auto const target_idx = static_cast<std::size_t>(
+            std::lower_bound(begin(task.targets_), end(task.targets_),
+                             pf_idx) -
+            begin(task.targets_));
+        auto const& info = infos[p][target_idx];
+
+        if (!info.has_value()) {
+          return;
+        }
+
+        tres.to_locs_.emplace_back(to_loc);
+        tres.infos_.emplace_back(*info);
+      });
+    }
+  }
+}
+
+// Appends the mirrored `transfer_info`s (see `prune_symmetric_pairs`) to the
+// `transfer_result`s of all `transfer_request`s covered by the given
+// `routing_task`.
+template <typename Requests>
+void expand_mirrored_targets(
+    routing_task const& task,
+    std::vector<std::optional<transfer_info>> const& mirror,
+    Requests const& reqs, std::vector<transfer_result>& result) {
+  for (auto const& prf : task.profiles_) {
+    if (prf.mirror_in_.empty()) {
+      continue;
+    }
+
+    for (auto const treq_idx : prf.treqs_) {
+      auto& tres = result[treq_idx];
+
+      reqs.for_each_target(treq_idx, [&](platform_idx_t const pf_idx,
+                                         location_key_t const to_loc) {
+        auto const target_idx = static_cast<std::uint32_t>(
+            std::lower_bound(begin(task.targets_), end(task.targets_),
+                             pf_idx) -
+            begin(task.targets_));
+        auto const it =
+            std::lower_bound(begin(prf.mirror_in_), end(prf.mirror_in_),
+                             std::pair{target_idx, std::size_t{0}});
+        if (it == end(prf.mirror_in_) || it->first != target_idx ||
+            !mirror[it->second].has_value()) {
+          return;
+        }
+
+        tres.to_locs_.emplace_back(to_loc);
+        tres.infos_.emplace_back(*mirror[it->second]);
+      });
+    }
+  }
+}
+
+std::vector<transfer_result> route_multiple_requests(
+    std::vector<transfer_request> const& treqs, platform_table const& pfs,
+    ::ppr::routing_graph const& rg,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric,
+    std::vector<routing_query_stats>* stats,
+    thread_placement const& threads) {
+  return route_multiple_requests(
+      treqs, pfs,
+      [&rg](pr::routing_query const& rq) { return pr::find_routes_v2(rg, rq); },
+      profiles, symmetric, stats, threads);
+}
+
+template <typename Requests>
+std::vector<transfer_result> route_requests(
+    Requests const& reqs, platform_table const& pfs, router_t const& router,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric,
+    std::vector<routing_query_stats>* stats,
+    thread_placement const& threads) {
+  // profiles with equal search parameters are routed once
+  auto const canonical = get_canonical_profiles(profiles);
+  auto tasks = build_routing_tasks(reqs, canonical);
+
+  // symmetric profiles: route every pair in one direction only (tasks refer
+  // to canonical profiles)
+  auto mirror = std::vector<std::optional<transfer_info>>(prune_symmetric_pairs(
+      tasks, get_symmetric_canonical_profiles(canonical, symmetric)));
+
+  // every request owns its slot in the result: workers write without locking
+  // and the result order equals the request order
+  auto result = std::vector<transfer_result>(reqs.size());
 
   auto progress_tracker = utl::get_active_progress_tracker();
 
-  boost::mutex mutex;
-  utl::parallel_for(treqs, [&](auto const& treq) {
-    auto single_result = route_single_request(treq, rg, profiles);
-    {
-      boost::unique_lock<boost::mutex> const scoped_lock(mutex);
-      result.emplace_back(single_result);
+  // route spatially close tasks on the same worker (routing graph cache
+  // locality); chunks are balanced by the estimated routing cost
+  auto scheduler = make_spatial_scheduler(
+      utl::to_vec(tasks,
+                  [&](routing_task const& task) {
+                    return hilbert_index(pfs.get(task.start_).loc_);
+                  }),
+      utl::to_vec(tasks,
+                  [&](routing_task const& task) {
+                    return estimate_routing_cost(task, profiles);
+                  }),
+      threads.n_threads());
+  scheduler.set_placement(threads);
+
+  auto scratches = std::vector<routing_scratch>(scheduler.n_workers());
+  for (auto& scratch : scratches) {
+    scratch.record_stats_ = stats != nullptr;
+  }
+
+  scheduler.run([&](std::size_t const worker, std::size_t const i) {
+    auto& scratch = scratches[worker];
+    route_routing_task(tasks[i], pfs, router, profiles, scratch);
+    expand_routing_task(tasks[i], scratch.infos_, reqs, result);
+
+    // every mirror slot is written by exactly one task
+    for (auto p = std::size_t{0}; p < tasks[i].profiles_.size(); ++p) {
+      for (auto const& [j, slot] : tasks[i].profiles_[p].mirror_out_) {
+        mirror[slot] = scratch.infos_[p][j];
+      }
+    }
+    for (auto const& prf : tasks[i].profiles_) {
+      progress_tracker->increment(prf.treqs_.size());
     }
-    progress_tracker->increment();
   });
 
+  // mirrored targets: available as soon as all tasks are routed
+  if (!mirror.empty()) {
+    for (auto const& task : tasks) {
+      expand_mirrored_targets(task, mirror, reqs, result);
+    }
+  }
+
+  if (stats != nullptr) {
+    for (auto const& scratch : scratches) {
+      stats->insert(end(*stats), begin(scratch.stats_), end(scratch.stats_));
+    }
+  }
+
+  // remove results of requests without any reached target
+  result.erase(std::remove_if(begin(result), end(result),
+                              [](transfer_result const& tres) {
+                                return tres.infos_.empty();
+                              }),
+               end(result));
+
   return result;
 }
 
+std::vector<transfer_result> route_multiple_requests(
+    std::vector<transfer_request> const& treqs, platform_table const& pfs,
+    router_t const& router,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric,
+    std::vector<routing_query_stats>* stats,
+    thread_placement const& threads) {
+  return route_requests(expanded_requests{treqs}, pfs, router, profiles,
+                        symmetric, stats, threads);
+}
+
+std::vector<transfer_result> route_multiple_requests(
+    transfer_request_by_keys_csr const& treqs_k, std::size_t const first,
+    std::size_t const last, platform_table const& pfs,
+    ::ppr::routing_graph const& rg,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric,
+    std::vector<routing_query_stats>* stats,
+    thread_placement const& threads) {
+  return route_multiple_requests(
+      treqs_k, first, last, pfs,
+      [&rg](pr::routing_query const& rq) { return pr::find_routes_v2(rg, rq); },
+      profiles, symmetric, stats, threads);
+}
+
+std::vector<transfer_result> route_multiple_requests(
+    transfer_request_by_keys_csr const& treqs_k, std::size_t const first,
+    std::size_t const last, platform_table const& pfs, router_t const& router,
+    hash_map<profile_key_t, pr::search_profile> const& profiles,
+    set<profile_key_t> const& symmetric,
+    std::vector<routing_query_stats>* stats,
+    thread_placement const& threads) {
+  utl::verify(first <= last && last <= treqs_k.size(),
+              "route_multiple_requests: invalid range [{}, {})", first, last);
+  return route_requests(key_form_requests{treqs_k, pfs, first, last - first},
+                        pfs, router, profiles, symmetric, stats, threads);
+}
+
 transfer_result merge(transfer_result const& a, transfer_result const& b) {
   auto merged = transfer_result{};
   auto added_to_nlocs = set<location_key_t>{};
@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+#include "transfers/storage/bounded_queue.h"
+
+TEST(bounded_queue, fifo_order) {
+  using namespace transfers;
+
+  auto queue = bounded_queue<int>{2U};
+  auto popped = std::vector<int>{};
+
+  auto consumer = std::thread{[&]() {
+    while (auto const el = queue.pop()) {
+      popped.emplace_back(*el);
+    }
+  }};
+
+  for (auto i = 0; i < 100; ++i) {
+    ASSERT_TRUE(queue.push(i));
+  }
+  queue.close();
+  consumer.join();
+
+  ASSERT_EQ(popped.size(), 100U);
+  for (auto i = 0; i < 100; ++i) {
+    ASSERT_EQ(popped[static_cast<std::size_t>(i)], i);
+  }
+}
+
+TEST(bounded_queue, closed) {
+  using namespace transfers;
+
+  auto queue = bounded_queue<int>{2U};
+  ASSERT_TRUE(queue.push(1));
+  queue.close();
+
+  ASSERT_FALSE(queue.push(2));
+  ASSERT_EQ(queue.pop(), std::optional<int>{1});
+  ASSERT_EQ(queue.pop(), std::nullopt);
+}
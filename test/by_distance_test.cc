@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "transfers/matching/by_distance.h"
+#include "transfers/platform/platform_index.h"
+
+#include "nigiri/location.h"
+#include "nigiri/timetable.h"
+
+namespace n = ::nigiri;
+
+namespace {
+
+// approximate length of one meter in degrees latitude
+constexpr auto const kDegreesPerMeter = 1.0 / 111'320.0;
+
+geo::latlng north_of(geo::latlng const& pos, double const meters) {
+  return {pos.lat_ + meters * kDegreesPerMeter, pos.lng_};
+}
+
+n::location_idx_t add_location(n::timetable& tt, std::string const& id,
+                               geo::latlng const& pos,
+                               n::location_idx_t const parent) {
+  auto const no_equivalences = n::vector<n::location_idx_t>{};
+  return tt.locations_.register_location(n::location{
+      id, id, pos, n::source_idx_t{0U}, n::location_type::kStation, parent,
+      n::timezone_idx_t::invalid(), n::duration_t{0},
+      n::it_range{no_equivalences.begin(), no_equivalences.end()}});
+}
+
+transfers::platform make_platform(std::int64_t const osm_id,
+                                  geo::latlng const& pos,
+                                  bool const is_bus_stop) {
+  auto pf = transfers::platform{};
+  pf.osm_id_ = osm_id;
+  pf.loc_ = pos;
+  pf.is_bus_stop_ = is_bus_stop;
+  return pf;
+}
+
+}  // namespace
+
+TEST(distance_matcher, group_locations) {
+  using namespace transfers;
+
+  auto const station_pos = geo::latlng{49.8728, 8.6512};
+  auto const bus_pos = geo::latlng{49.8800, 8.6600};
+
+  auto tt = n::timetable{};
+  // station with a co-located stop point and a stop point 120 m away
+  auto const station =
+      add_location(tt, "station", station_pos, n::location_idx_t::invalid());
+  auto const close = add_location(tt, "close", north_of(station_pos, 3.0),
+                                  station);
+  auto const far = add_location(tt, "far", north_of(station_pos, 120.0),
+                                station);
+  // two co-located stops: only the first is in the bus stop matching distance
+  // of the bus stop platform
+  auto const bus_a = add_location(tt, "bus_a", north_of(bus_pos, 4.0),
+                                  n::location_idx_t::invalid());
+  auto const bus_b = add_location(tt, "bus_b", north_of(bus_pos, -6.0),
+                                  n::location_idx_t::invalid());
+
+  auto const old_pfs = platform_index{std::vector<platform>{
+      make_platform(1, north_of(station_pos, 2.0), false),
+      make_platform(2, north_of(station_pos, 125.0), false),
+      make_platform(3, bus_pos, true),
+      make_platform(4, north_of(bus_pos, -20.0), false)}};
+  auto const update_pfs = platform_index{std::vector<platform>{}};
+  auto const already_matched = hash_map<location_key_t, platform>{};
+
+  auto const data = matching_data{tt.locations_, already_matched, old_pfs,
+                                  update_pfs, false};
+  auto const options = matching_options{.max_matching_dist_ = 30.0,
+                                        .max_bus_stop_matching_dist_ = 5.0,
+                                        .group_locations_ = true,
+                                        .group_tolerance_ = 12.0};
+
+  auto osm_ids = hash_map<location_key_t, std::int64_t>{};
+  for (auto const& match : distance_matcher{data, options}.matching()) {
+    osm_ids.emplace(match.loc_.key(), match.pf_.osm_id_);
+  }
+
+  auto const get_osm_id = [&](n::location_idx_t const l) {
+    auto const it =
+        osm_ids.find(location{tt.locations_.coordinates_[l]}.key());
+    return it == end(osm_ids) ? std::int64_t{-1} : it->second;
+  };
+
+  ASSERT_EQ(osm_ids.size(), 5U);
+
+  // grouped: the co-located stop point shares the match of the station
+  ASSERT_EQ(get_osm_id(station), 1);
+  ASSERT_EQ(get_osm_id(close), 1);
+
+  // same station, but not co-located: matched on its own
+  ASSERT_EQ(get_osm_id(far), 2);
+
+  // fallback: out of the bus stop matching distance of the group platform
+  ASSERT_EQ(get_osm_id(bus_a), 3);
+  ASSERT_EQ(get_osm_id(bus_b), 4);
+}
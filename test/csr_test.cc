@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include <iterator>
+#include <vector>
+
+#include "transfers/transfer/transfer_request.h"
+
+TEST(transfer_request_by_keys_csr, empty) {
+  using namespace transfers;
+
+  auto csr = transfer_request_by_keys_csr{};
+
+  ASSERT_TRUE(csr.empty());
+  ASSERT_EQ(csr.size(), 0U);
+  ASSERT_EQ(csr.begin(), csr.end());
+}
+
+TEST(transfer_request_by_keys_csr, emplace_back) {
+  using namespace transfers;
+
+  auto treq_k = transfer_request_by_keys{};
+  treq_k.from_loc_ = location_key_t{26};
+  treq_k.profile_ = profile_key_t{1};
+  treq_k.to_locs_ = {location_key_t{1}, location_key_t{2}, location_key_t{3}};
+
+  auto const to_locs = std::vector<location_key_t>{location_key_t{4}};
+
+  auto csr = transfer_request_by_keys_csr{};
+  csr.emplace_back(treq_k);
+  csr.emplace_back(location_key_t{27}, to_locs, profile_key_t{2});
+
+  ASSERT_EQ(csr.size(), 2U);
+  ASSERT_EQ(csr[0].to_transfer_request_by_keys(), treq_k);
+  ASSERT_EQ(csr[0].key(), treq_k.key());
+  ASSERT_EQ(csr[1].from_loc_, location_key_t{27});
+  ASSERT_EQ(csr[1].profile_, profile_key_t{2});
+  ASSERT_EQ(csr[1].to_locs_.size(), 1U);
+  ASSERT_EQ(csr[1].to_locs_.front(), location_key_t{4});
+}
+
+TEST(transfer_request_by_keys_csr, iterator) {
+  using namespace transfers;
+
+  static_assert(
+      std::forward_iterator<transfer_request_by_keys_csr::const_iterator>);
+
+  auto const to_locs = std::vector<location_key_t>{location_key_t{4}};
+
+  auto csr = transfer_request_by_keys_csr{};
+  csr.emplace_back(location_key_t{26}, to_locs, profile_key_t{1});
+  csr.emplace_back(location_key_t{27}, to_locs, profile_key_t{2});
+
+  auto it = csr.begin();
+  ASSERT_EQ((*it++).from_loc_, location_key_t{26});
+  ASSERT_EQ((*it).from_loc_, location_key_t{27});
+  ASSERT_EQ(++it, csr.end());
+  ASSERT_EQ(std::distance(csr.begin(), csr.end()), 2);
+}
+
+TEST(transfer_request_by_keys_csr, append) {
+  using namespace transfers;
+
+  auto const to_locs_a =
+      std::vector<location_key_t>{location_key_t{1}, location_key_t{2}};
+  auto const to_locs_b =
+      std::vector<location_key_t>{location_key_t{3}, location_key_t{4},
+                                  location_key_t{5}};
+
+  auto csr_a = transfer_request_by_keys_csr{};
+  csr_a.emplace_back(location_key_t{26}, to_locs_a, profile_key_t{1});
+
+  auto csr_b = transfer_request_by_keys_csr{};
+  csr_b.emplace_back(location_key_t{27}, to_locs_b, profile_key_t{1});
+  csr_b.emplace_back(location_key_t{28}, to_locs_a, profile_key_t{2});
+
+  csr_a.append(csr_b);
+
+  auto from_locs = std::vector<location_key_t>{};
+  auto n_to_locs = std::vector<std::size_t>{};
+  for (auto const treq_k : csr_a) {
+    from_locs.emplace_back(treq_k.from_loc_);
+    n_to_locs.emplace_back(treq_k.to_locs_.size());
+  }
+
+  ASSERT_EQ(from_locs, (std::vector<location_key_t>{
+                           location_key_t{26}, location_key_t{27},
+                           location_key_t{28}}));
+  ASSERT_EQ(n_to_locs, (std::vector<std::size_t>{2U, 3U, 2U}));
+  ASSERT_EQ(csr_a[1].to_locs_.back(), location_key_t{5});
+  ASSERT_EQ(csr_a[2].to_locs_.front(), location_key_t{1});
+}
+
+TEST(transfer_request_by_keys_csr, clear) {
+  using namespace transfers;
+
+  auto const to_locs = std::vector<location_key_t>{location_key_t{1}};
+
+  auto csr = transfer_request_by_keys_csr{};
+  csr.emplace_back(location_key_t{26}, to_locs, profile_key_t{1});
+  csr.clear();
+
+  ASSERT_TRUE(csr.empty());
+
+  csr.emplace_back(location_key_t{27}, to_locs, profile_key_t{1});
+
+  ASSERT_EQ(csr.size(), 1U);
+  ASSERT_EQ(csr[0].from_loc_, location_key_t{27});
+  ASSERT_EQ(csr[0].to_locs_.size(), 1U);
+}
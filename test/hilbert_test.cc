@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+
+#include "transfers/platform/hilbert.h"
+
+TEST(hilbert, quadrant_order) {
+  using namespace transfers;
+
+  // first level of the curve: south-west, north-west, north-east, south-east
+  auto const sw = hilbert_index(geo::latlng{-45.0, -90.0});
+  auto const nw = hilbert_index(geo::latlng{45.0, -90.0});
+  auto const ne = hilbert_index(geo::latlng{45.0, 90.0});
+  auto const se = hilbert_index(geo::latlng{-45.0, 90.0});
+
+  ASSERT_LT(sw, nw);
+  ASSERT_LT(nw, ne);
+  ASSERT_LT(ne, se);
+}
+
+TEST(hilbert, locality) {
+  using namespace transfers;
+
+  auto const a = hilbert_index(geo::latlng{49.8728, 8.6512});
+  auto const b = hilbert_index(geo::latlng{49.8729, 8.6513});
+  auto const far = hilbert_index(geo::latlng{-33.8688, 151.2093});
+
+  auto const dist = [](std::uint64_t const x, std::uint64_t const y) {
+    return x < y ? y - x : x - y;
+  };
+
+  ASSERT_LT(dist(a, b), dist(a, far));
+}
+
+TEST(hilbert, bounds) {
+  using namespace transfers;
+
+  ASSERT_EQ(hilbert_index(geo::latlng{-90.0, -180.0}), 0U);
+  ASSERT_EQ(hilbert_index(geo::latlng{-100.0, -200.0}), 0U);
+}
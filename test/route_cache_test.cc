@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+
+#include <optional>
+#include <vector>
+
+#include "transfers/transfer/route_cache.h"
+
+namespace {
+
+transfers::platform make_platform(std::int64_t const osm_id, double const lat,
+                                  double const lng) {
+  auto pf = transfers::platform{};
+  pf.osm_id_ = osm_id;
+  pf.loc_ = geo::latlng{lat, lng};
+  return pf;
+}
+
+}  // namespace
+
+TEST(route_cache, split_and_store) {
+  using namespace transfers;
+
+  auto const loc_a = location{49.87, 8.65};
+  auto const loc_b = location{49.88, 8.66};
+  auto const loc_c = location{49.89, 8.67};
+
+  auto pfs = platform_table{};
+  pfs.add(loc_a.key(), make_platform(1, 49.87, 8.65));
+  pfs.add(loc_b.key(), make_platform(2, 49.88, 8.66));
+  pfs.add(loc_c.key(), make_platform(3, 49.89, 8.67));
+
+  auto treq = transfer_request{};
+  treq.transfer_start_ = pfs.get_idx(loc_a.key());
+  treq.from_loc_ = loc_a;
+  treq.transfer_targets_ = {pfs.get_idx(loc_b.key()),
+                            pfs.get_idx(loc_c.key())};
+  treq.to_locs_ = {loc_b, loc_c};
+  treq.profile_ = profile_key_t{1};
+  auto const treqs = std::vector<transfer_request>{treq};
+
+  auto const profile_hashes =
+      hash_map<profile_key_t, std::uint64_t>{{profile_key_t{1}, 42U}};
+  auto const keys = get_route_cache_keys(treqs, pfs, profile_hashes);
+  ASSERT_EQ(keys.size(), 2U);
+  ASSERT_NE(keys[0], keys[1]);
+
+  // nothing cached: route everything
+  auto const empty = split_cached_routes(
+      treqs, pfs, std::vector<std::optional<route_cache_entry>>(2U));
+  ASSERT_TRUE(empty.cached_.empty());
+  ASSERT_EQ(empty.uncached_.size(), 1U);
+  ASSERT_EQ(empty.uncached_[0].transfer_targets_.size(), 2U);
+
+  // routing reached b only: c is cached as unreachable
+  auto routed = transfer_result{};
+  routed.from_loc_ = loc_a.key();
+  routed.profile_ = profile_key_t{1};
+  routed.to_locs_.emplace_back(loc_b.key());
+  routed.infos_.emplace_back(transfer_info{::nigiri::duration_t{2}, 120.0});
+
+  auto const entries = to_route_cache_entries(
+      treqs, std::vector<transfer_result>{routed}, pfs, profile_hashes);
+  ASSERT_EQ(entries.size(), 2U);
+  ASSERT_EQ(entries[0].first, keys[0]);
+  ASSERT_TRUE(entries[0].second.reached_);
+  ASSERT_FALSE(entries[1].second.reached_);
+
+  // everything cached: nothing to route
+  auto const cached = split_cached_routes(
+      treqs, pfs,
+      std::vector<std::optional<route_cache_entry>>{entries[0].second,
+                                                    entries[1].second});
+  ASSERT_TRUE(cached.uncached_.empty());
+  ASSERT_EQ(cached.cached_.size(), 1U);
+  ASSERT_EQ(cached.cached_[0], routed);
+
+  // moved target platform: route again
+  auto moved = entries[1].second;
+  moved.to_ = geo::latlng{49.90, 8.68};
+  auto const partial = split_cached_routes(
+      treqs, pfs,
+      std::vector<std::optional<route_cache_entry>>{entries[0].second, moved});
+  ASSERT_EQ(partial.uncached_.size(), 1U);
+  ASSERT_EQ(partial.uncached_[0].transfer_targets_,
+            (std::vector<platform_idx_t>{pfs.get_idx(loc_c.key())}));
+}
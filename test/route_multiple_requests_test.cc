@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "transfers/transfer/transfer_result.h"
+
+#include "routing_fixture.h"
+
+namespace pr = ::ppr::routing;
+
+TEST(route_multiple_requests, key_form_equals_expanded) {
+  using namespace transfers;
+
+  auto const f = make_routing_fixture(5U);
+
+  // all pairs for two profiles
+  auto treqs_k = transfer_request_by_keys_csr{};
+  for (auto const prf : {profile_key_t{1}, profile_key_t{2}}) {
+    for (auto const& from : f.locs_) {
+      auto to_locs = std::vector<location_key_t>{};
+      for (auto const& to : f.locs_) {
+        if (to.key() != from.key()) {
+          to_locs.emplace_back(to.key());
+        }
+      }
+      treqs_k.emplace_back(from.key(), to_locs, prf);
+    }
+  }
+
+  auto n_routed = std::atomic<std::size_t>{0U};
+  auto const router = [&](pr::routing_query const& rq) {
+    return route_beeline(rq, n_routed);
+  };
+
+  auto const expanded = route_multiple_requests(
+      to_transfer_requests(treqs_k, f.pfs_, 2U, 8U), f.pfs_, router,
+      f.profiles_, set<profile_key_t>{profile_key_t{1}});
+  auto const key_form =
+      route_multiple_requests(treqs_k, 2U, 8U, f.pfs_, router, f.profiles_,
+                              set<profile_key_t>{profile_key_t{1}});
+
+  ASSERT_FALSE(key_form.empty());
+  ASSERT_EQ(expanded, key_form);
+}
+
+TEST(route_multiple_requests, alias_profiles_routed_once) {
+  using namespace transfers;
+
+  // profiles 1 and 3: same search parameters (aliases)
+  auto f = make_routing_fixture(3U);
+  f.profiles_[profile_key_t{3}] = f.profiles_[profile_key_t{1}];
+
+  auto treqs_k = transfer_request_by_keys_csr{};
+  for (auto const prf :
+       {profile_key_t{1}, profile_key_t{2}, profile_key_t{3}}) {
+    auto const to_locs =
+        std::vector<location_key_t>{f.locs_[1].key(), f.locs_[2].key()};
+    treqs_k.emplace_back(f.locs_[0].key(), to_locs, prf);
+  }
+
+  auto n_routed = std::atomic<std::size_t>{0U};
+  auto const tres = route_multiple_requests(
+      treqs_k, 0U, treqs_k.size(), f.pfs_,
+      [&](pr::routing_query const& rq) { return route_beeline(rq, n_routed); },
+      f.profiles_);
+
+  // profiles 1 and 3 share one search
+  ASSERT_EQ(n_routed.load(), 4U);
+
+  ASSERT_EQ(tres.size(), 3U);
+  ASSERT_EQ(tres[0].profile_, profile_key_t{1});
+  ASSERT_EQ(tres[2].profile_, profile_key_t{3});
+  ASSERT_EQ(tres[0].to_locs_, tres[2].to_locs_);
+  ASSERT_EQ(tres[0].infos_, tres[2].infos_);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "transfers/platform/platform.h"
+#include "transfers/platform/platform_table.h"
+#include "transfers/types.h"
+
+#include "geo/latlng.h"
+
+#include "ppr/routing/routing_query.h"
+#include "ppr/routing/search.h"
+#include "ppr/routing/search_profile.h"
+
+namespace transfers {
+
+// Platforms of up to five nearby locations and two search profiles:
+// profile 1 (1.4 m/s) and profile 2 (0.8 m/s), both limited to 300 s.
+struct routing_fixture {
+  platform_table pfs_;
+  std::vector<location> locs_;
+  hash_map<profile_key_t, ::ppr::routing::search_profile> profiles_;
+};
+
+inline routing_fixture make_routing_fixture(std::size_t const n_locs) {
+  auto const coords = std::vector<geo::latlng>{
+      {49.8728, 8.6512}, {49.8731, 8.6520}, {49.8740, 8.6490},
+      {49.8700, 8.6530}, {49.8755, 8.6550}};
+
+  auto f = routing_fixture{};
+  for (auto i = std::size_t{0}; i < n_locs && i < coords.size(); ++i) {
+    auto pf = platform{};
+    pf.osm_id_ = static_cast<std::int64_t>(i + 1U);
+    pf.loc_ = coords[i];
+    f.locs_.emplace_back(coords[i]);
+    f.pfs_.add(f.locs_.back().key(), pf);
+  }
+
+  f.profiles_[profile_key_t{1}].walking_speed_ = 1.4;
+  f.profiles_[profile_key_t{1}].duration_limit_ = 300.0;
+  f.profiles_[profile_key_t{2}].walking_speed_ = 0.8;
+  f.profiles_[profile_key_t{2}].duration_limit_ = 300.0;
+  return f;
+}
+
+// Symmetric fake router: beeline distance and walking speed of the profile.
+// Counts the routed destinations in `n_destinations`.
+inline ::ppr::routing::search_result route_beeline(
+    ::ppr::routing::routing_query const& rq,
+    std::atomic<std::size_t>& n_destinations) {
+  namespace pr = ::ppr::routing;
+
+  n_destinations += rq.destinations_.size();
+
+  auto const from =
+      geo::latlng{rq.start_.location_.lat(), rq.start_.location_.lon()};
+
+  auto res = pr::search_result{};
+  res.routes_.resize(rq.destinations_.size());
+  for (auto i = std::size_t{0}; i < rq.destinations_.size(); ++i) {
+    auto const to = geo::latlng{rq.destinations_[i].location_.lat(),
+                                rq.destinations_[i].location_.lon()};
+    auto const dist = geo::distance(from, to);
+    if (dist > rq.profile_.walking_speed_ * rq.profile_.duration_limit_) {
+      continue;
+    }
+
+    auto r = pr::route{};
+    r.distance_ = dist;
+    r.duration_ = dist / rq.profile_.walking_speed_;
+    res.routes_[i].emplace_back(r);
+  }
+  return res;
+}
+
+}  // namespace transfers
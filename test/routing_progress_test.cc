@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "transfers/storage/database.h"
+
+TEST(routing_progress, resume_interrupted_partial_update) {
+  using namespace transfers;
+  namespace fs = std::filesystem;
+
+  auto const db_path = fs::temp_directory_path() / "transfers_resume_test.db";
+  auto lock_path = db_path;
+  lock_path += "-lock";
+  fs::remove(db_path);
+  fs::remove(lock_path);
+
+  auto const to_locs = std::vector<location_key_t>{location_key_t{1}};
+  auto old = transfer_request_by_keys_csr{};
+  old.emplace_back(location_key_t{24}, to_locs, profile_key_t{1});
+  old.emplace_back(location_key_t{25}, to_locs, profile_key_t{3});
+  auto update = transfer_request_by_keys_csr{};
+  update.emplace_back(location_key_t{26}, to_locs, profile_key_t{1});
+  update.emplace_back(location_key_t{27}, to_locs, profile_key_t{1});
+  update.emplace_back(location_key_t{28}, to_locs, profile_key_t{2});
+
+  auto const old_phase = std::uint8_t{0U};
+  auto const update_phase = std::uint8_t{1U};
+
+  // 1st run: the update requests are stored as transfer requests, the run is
+  // interrupted after the results of the first request are stored
+  {
+    auto db = database{db_path, 16U * 1024U * 1024U};
+    db.put_transfer_requests_by_keys(old);
+    db.put_transfer_requests_by_keys(update);
+
+    auto const run = get_routing_run(
+        update, db.get_routing_progress(update_phase),
+        [&](set<profile_key_t> const& profiles) {
+          return db.get_transfer_requests_by_keys(profiles);
+        });
+    ASSERT_EQ(run.first_, 0U);
+    ASSERT_EQ(run.requests_.hash(), update.hash());
+    ASSERT_EQ(get_profiles(run.profiles_),
+              (set<profile_key_t>{profile_key_t{1}, profile_key_t{2}}));
+
+    db.put_routing_progress(update_phase,
+                            {run.requests_.hash(), 1U, run.profiles_});
+  }
+
+  // restart: the update requests are not regenerated, all stored transfer
+  // requests of the profiles of the run are routed
+  {
+    auto db = database{db_path, 16U * 1024U * 1024U};
+    ASSERT_FALSE(db.get_routing_progress(old_phase).has_value());
+
+    auto const get_stored_requests = [&](set<profile_key_t> const& profiles) {
+      return db.get_transfer_requests_by_keys(profiles);
+    };
+
+    // same requests: resume after the stored results
+    auto const resumed = get_routing_run(
+        update, db.get_routing_progress(update_phase), get_stored_requests);
+    ASSERT_EQ(resumed.first_, 1U);
+    ASSERT_EQ(resumed.requests_.size(), 3U);
+
+    auto const rebuilt = get_routing_run(transfer_request_by_keys_csr{},
+                                         db.get_routing_progress(update_phase),
+                                         get_stored_requests);
+    ASSERT_EQ(rebuilt.first_, 0U);
+    ASSERT_EQ(rebuilt.requests_.size(), 4U);
+    for (auto const treq_k : rebuilt.requests_) {
+      ASSERT_TRUE(treq_k.profile_ != profile_key_t{3});
+    }
+
+    // interrupted again: the rebuilt run is resumed
+    db.put_routing_progress(update_phase,
+                            {rebuilt.requests_.hash(), 2U, rebuilt.profiles_});
+    auto const rebuilt_again = get_routing_run(
+        transfer_request_by_keys_csr{}, db.get_routing_progress(update_phase),
+        get_stored_requests);
+    ASSERT_EQ(rebuilt_again.first_, 2U);
+    ASSERT_EQ(rebuilt_again.requests_.hash(), rebuilt.requests_.hash());
+
+    // completed phase: nothing left to resume
+    db.delete_routing_progress(update_phase);
+    ASSERT_FALSE(db.get_routing_progress(update_phase).has_value());
+  }
+
+  fs::remove(db_path);
+  fs::remove(lock_path);
+}
@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "transfers/transfer/routing_region.h"
+
+#include "geo/box.h"
+#include "geo/latlng.h"
+
+TEST(routing_region, buffer_box) {
+  using namespace transfers;
+
+  auto bbox = geo::box{};
+  bbox.extend(geo::latlng{49.87, 8.65});
+  bbox.extend(geo::latlng{49.88, 8.66});
+
+  auto const buffered = buffer_box(bbox, 1'000.0);
+  EXPECT_TRUE(contains(buffered, bbox));
+  EXPECT_FALSE(contains(bbox, buffered));
+  EXPECT_NEAR(buffered.max_.lat_ - bbox.max_.lat_, 0.009, 0.0001);
+  EXPECT_GT(buffered.max_.lng_ - bbox.max_.lng_,
+            buffered.max_.lat_ - bbox.max_.lat_);
+}
+
+TEST(routing_region, select_routing_graph) {
+  using namespace transfers;
+
+  auto const make_box = [](geo::latlng const& a, geo::latlng const& b) {
+    auto bbox = geo::box{};
+    bbox.extend(a);
+    bbox.extend(b);
+    return bbox;
+  };
+
+  auto const tiles = std::vector<routing_graph_tile>{
+      {"germany.ppr", make_box({47.0, 5.0}, {55.0, 15.0})},
+      {"hesse.ppr", make_box({49.3, 7.7}, {51.7, 10.3})},
+      {"bavaria.ppr", make_box({47.2, 8.9}, {50.6, 13.9})}};
+
+  auto const darmstadt = make_box({49.85, 8.62}, {49.90, 8.70});
+  auto const frankfurt_munich = make_box({48.1, 8.6}, {50.2, 11.6});
+  auto const paris = make_box({48.8, 2.3}, {48.9, 2.4});
+
+  EXPECT_EQ("hesse.ppr", select_routing_graph(tiles, darmstadt, "full.ppr"));
+  EXPECT_EQ("germany.ppr",
+            select_routing_graph(tiles, frankfurt_munich, "full.ppr"));
+  EXPECT_EQ("full.ppr", select_routing_graph(tiles, paris, "full.ppr"));
+  EXPECT_EQ("full.ppr", select_routing_graph({}, darmstadt, "full.ppr"));
+}
@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "transfers/transfer/routing_scheduler.h"
+
+TEST(routing_scheduler, runs_every_task_once) {
+  using namespace transfers;
+
+  auto const costs = std::vector<double>{3.0, 100.0, 1.0, 7.0, 7.0,
+                                         42.0, 0.0, 5.0, 9.0, 2.0};
+  auto const spatial_keys = std::vector<std::uint64_t>{9U, 8U, 7U, 6U, 5U,
+                                                       4U, 3U, 2U, 1U, 0U};
+
+  for (auto const n_workers : {1U, 2U, 3U, 16U}) {
+    auto runs = std::vector<std::atomic<int>>(costs.size());
+
+    auto scheduler = make_spatial_scheduler(spatial_keys, costs, n_workers);
+    scheduler.run([&](std::size_t, std::size_t const i) { ++runs[i]; });
+
+    for (auto const& r : runs) {
+      ASSERT_EQ(r.load(), 1);
+    }
+  }
+}
+
+TEST(routing_scheduler, largest_first) {
+  using namespace transfers;
+
+  auto const spatial_keys =
+      std::vector<std::uint64_t>{50U, 40U, 30U, 20U, 10U};
+  auto const costs = std::vector<double>{1.0, 5.0, 3.0, 5.0, 2.0};
+
+  // by cost, ties in curve order
+  auto order = std::vector<std::size_t>{};
+  auto scheduler = make_spatial_scheduler(spatial_keys, costs, 1U);
+  scheduler.run(
+      [&](std::size_t, std::size_t const i) { order.emplace_back(i); });
+
+  ASSERT_EQ(order, (std::vector<std::size_t>{3U, 1U, 2U, 4U, 0U}));
+}
+
+TEST(routing_scheduler, no_tasks) {
+  using namespace transfers;
+
+  auto scheduler = make_spatial_scheduler({}, {}, 4U);
+  auto n_runs = 0U;
+  scheduler.run([&](std::size_t, std::size_t) { ++n_runs; });
+
+  ASSERT_EQ(n_runs, 0U);
+}
+
+TEST(routing_scheduler, spatial_chunks) {
+  using namespace transfers;
+
+  auto const spatial_keys =
+      std::vector<std::uint64_t>{40U, 10U, 30U, 20U, 60U, 50U};
+  auto const costs = std::vector<double>(spatial_keys.size(), 1.0);
+
+  auto order = std::vector<std::size_t>{};
+  auto single = make_spatial_scheduler(spatial_keys, costs, 1U);
+  single.run(
+      [&](std::size_t, std::size_t const i) { order.emplace_back(i); });
+
+  ASSERT_EQ(order, (std::vector<std::size_t>{1U, 3U, 2U, 0U, 5U, 4U}));
+
+  auto runs = std::vector<std::atomic<int>>(spatial_keys.size());
+  auto multi = make_spatial_scheduler(spatial_keys, costs, 3U);
+  ASSERT_EQ(multi.n_workers(), 3U);
+  multi.run([&](std::size_t, std::size_t const i) { ++runs[i]; });
+
+  for (auto const& r : runs) {
+    ASSERT_EQ(r.load(), 1);
+  }
+}
@@ -0,0 +1,148 @@
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "transfers/transfer/routing_shard.h"
+
+namespace pr = ::ppr::routing;
+
+TEST(routing_shard, make_routing_shards) {
+  using namespace transfers;
+
+  auto locs = std::vector<location>{};
+  auto matches = hash_map<location_key_t, platform>{};
+  for (auto i = 0; i < 8; ++i) {
+    locs.emplace_back(49.8 + 0.01 * i, 8.6 + 0.01 * i);
+
+    auto pf = platform{};
+    pf.osm_id_ = i + 1;
+    pf.loc_ = locs.back().to_latlng();
+    matches.emplace(locs.back().key(), pf);
+  }
+
+  auto treqs_k = transfer_request_by_keys_csr{};
+  for (auto i = std::size_t{0U}; i < locs.size(); ++i) {
+    auto const to_locs = std::vector<location_key_t>{
+        locs[(i + 1U) % locs.size()].key(), locs[(i + 2U) % locs.size()].key()};
+    treqs_k.emplace_back(locs[i].key(), to_locs, profile_key_t{1});
+  }
+
+  auto const profile_names =
+      hash_map<profile_key_t, string_t>{{profile_key_t{1}, string_t{"foot"}}};
+  auto profiles = hash_map<profile_key_t, pr::search_profile>{};
+  profiles[profile_key_t{1}].walking_speed_ = 1.4;
+  auto const shards =
+      make_routing_shards(treqs_k, matches, profile_names, profiles,
+                          set<profile_key_t>{profile_key_t{1}}, 3U);
+  ASSERT_EQ(shards.size(), 3U);
+
+  auto n_requests = std::size_t{0U};
+  for (auto const& shard : shards) {
+    auto const shard_treqs_k = get_transfer_requests_by_keys(shard);
+    auto const pfs = get_platform_table(shard);
+    n_requests += shard_treqs_k.size();
+
+    ASSERT_EQ(shard.profile_names_.size(), 1U);
+    ASSERT_EQ(get_symmetric_profiles(shard).count(profile_key_t{1}), 1U);
+    for (auto const treq_k : shard_treqs_k) {
+      ASSERT_EQ(treq_k.to_locs_.size(), 2U);
+
+      // all referenced locations are matched within the shard
+      ASSERT_EQ(pfs.get(pfs.get_idx(treq_k.from_loc_)).loc_,
+                matches.at(treq_k.from_loc_).loc_);
+      for (auto const to_loc : treq_k.to_locs_) {
+        ASSERT_EQ(pfs.get(pfs.get_idx(to_loc)).loc_, matches.at(to_loc).loc_);
+      }
+    }
+  }
+  ASSERT_EQ(n_requests, treqs_k.size());
+}
+
+TEST(routing_shard, search_profiles) {
+  using namespace transfers;
+
+  auto const loc_a = location{49.8, 8.6};
+  auto const loc_b = location{49.801, 8.6};
+  auto matches = hash_map<location_key_t, platform>{};
+  for (auto const& loc : {loc_a, loc_b}) {
+    auto pf = platform{};
+    pf.osm_id_ = static_cast<std::int64_t>(matches.size() + 1U);
+    pf.loc_ = loc.to_latlng();
+    matches.emplace(loc.key(), pf);
+  }
+
+  auto treqs_k = transfer_request_by_keys_csr{};
+  treqs_k.emplace_back(loc_a.key(), std::vector<location_key_t>{loc_b.key()},
+                       profile_key_t{1});
+
+  auto const profile_names =
+      hash_map<profile_key_t, string_t>{{profile_key_t{1}, string_t{"foot"}}};
+  auto profiles = hash_map<profile_key_t, pr::search_profile>{};
+  profiles[profile_key_t{1}].walking_speed_ = 1.4;
+  auto const shard =
+      make_routing_shards(treqs_k, matches, profile_names, profiles, {}, 1U)
+          .front();
+  ASSERT_TRUE(get_symmetric_profiles(shard).empty());
+
+  // the worker's search profile equals the exported one
+  auto name_to_profile = hash_map<std::string, pr::search_profile>{
+      {"foot", profiles.at(profile_key_t{1})}};
+  ASSERT_EQ(get_search_profiles(shard, name_to_profile).size(), 1U);
+
+  // changed parameters or missing profile
+  name_to_profile.at("foot").walking_speed_ = 1.0;
+  ASSERT_ANY_THROW(get_search_profiles(shard, name_to_profile));
+  ASSERT_ANY_THROW(get_search_profiles(shard, {}));
+}
+
+TEST(routing_shard, stale_results) {
+  using namespace transfers;
+  namespace fs = std::filesystem;
+
+  auto locs = std::vector<location>{};
+  auto matches = hash_map<location_key_t, platform>{};
+  for (auto i = 0; i < 4; ++i) {
+    locs.emplace_back(49.8 + 0.01 * i, 8.6 + 0.01 * i);
+
+    auto pf = platform{};
+    pf.osm_id_ = i + 1;
+    pf.loc_ = locs.back().to_latlng();
+    matches.emplace(locs.back().key(), pf);
+  }
+
+  auto const profile_names =
+      hash_map<profile_key_t, string_t>{{profile_key_t{1}, string_t{"foot"}}};
+  auto const to_locs = std::vector<location_key_t>{locs[3].key()};
+
+  auto treqs_a = transfer_request_by_keys_csr{};
+  treqs_a.emplace_back(locs[0].key(), to_locs, profile_key_t{1});
+  auto treqs_b = transfer_request_by_keys_csr{};
+  treqs_b.emplace_back(locs[1].key(), to_locs, profile_key_t{1});
+
+  auto const profiles = hash_map<profile_key_t, pr::search_profile>{
+      {profile_key_t{1}, pr::search_profile{}}};
+  auto const a = make_routing_shards(treqs_a, matches, profile_names,
+                                     profiles, {}, 1U);
+  auto const b = make_routing_shards(treqs_b, matches, profile_names,
+                                     profiles, {}, 1U);
+
+  auto result = routing_shard_result{};
+  result.shard_hash_ = a.front().hash_;
+  ASSERT_TRUE(is_result_of(result, a.front()));
+  ASSERT_FALSE(is_result_of(result, b.front()));
+
+  auto const dir = fs::temp_directory_path() / "transfers_shard_test";
+  fs::create_directories(dir);
+  write_routing_shard(routing_shard_path(dir, 0U), a.front());
+  write_routing_shard_result(routing_shard_result_path(dir, 0U), result);
+
+  remove_routing_shard_files(dir);
+  ASSERT_FALSE(fs::exists(routing_shard_path(dir, 0U)));
+  ASSERT_FALSE(fs::exists(routing_shard_result_path(dir, 0U)));
+
+  fs::remove_all(dir);
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "transfers/transfer/routing_stats.h"
+
+TEST(routing_stats, latency_bucket) {
+  using namespace transfers;
+
+  EXPECT_EQ(0U, get_latency_bucket(0U));
+  EXPECT_EQ(0U, get_latency_bucket(999U));
+  EXPECT_EQ(1U, get_latency_bucket(1'000U));
+  EXPECT_EQ(2U, get_latency_bucket(2'000U));
+  EXPECT_EQ(2U, get_latency_bucket(3'999U));
+  EXPECT_EQ(3U, get_latency_bucket(4'000U));
+  EXPECT_EQ(kLatencyBuckets - 1U, get_latency_bucket(3'600'000'000U));
+}
+
+TEST(routing_stats, summarize) {
+  using namespace transfers;
+
+  auto const queries = std::vector<routing_query_stats>{
+      {.start_ = 0U,
+       .profile_ = 2U,
+       .duration_us_ = 500U,
+       .n_targets_ = 4U,
+       .n_reached_ = 4U},
+      {.start_ = 1U,
+       .profile_ = 1U,
+       .duration_us_ = 9'000U,
+       .n_targets_ = 10U,
+       .n_reached_ = 3U},
+      {.start_ = 2U,
+       .profile_ = 2U,
+       .duration_us_ = 1'500U,
+       .n_targets_ = 2U,
+       .n_reached_ = 1U},
+      {.start_ = 3U,
+       .profile_ = 2U,
+       .duration_us_ = 20'000U,
+       .n_targets_ = 1U,
+       .n_reached_ = 0U}};
+
+  auto const summary = summarize_routing_stats(queries, 2U);
+
+  ASSERT_EQ(2U, summary.profiles_.size());
+  EXPECT_EQ(1U, summary.profiles_[0].profile_);
+  EXPECT_EQ(1U, summary.profiles_[0].n_queries_);
+  EXPECT_EQ(1U, summary.profiles_[0].histogram_[4]);
+
+  auto const& prf = summary.profiles_[1];
+  EXPECT_EQ(2U, prf.profile_);
+  EXPECT_EQ(3U, prf.n_queries_);
+  EXPECT_EQ(7U, prf.n_targets_);
+  EXPECT_EQ(5U, prf.n_reached_);
+  EXPECT_EQ(22'000U, prf.total_us_);
+  EXPECT_EQ(20'000U, prf.max_us_);
+  EXPECT_EQ(1U, prf.histogram_[0]);
+  EXPECT_EQ(1U, prf.histogram_[1]);
+  EXPECT_EQ(1U, prf.histogram_[5]);
+
+  ASSERT_EQ(2U, summary.slowest_.size());
+  EXPECT_EQ(3U, summary.slowest_[0].start_);
+  EXPECT_EQ(1U, summary.slowest_[1].start_);
+}
+
+TEST(routing_stats, aliases) {
+  using namespace transfers;
+
+  // profiles 1 and 3 share the queries of canonical profile 1
+  auto const queries = std::vector<routing_query_stats>{
+      {.start_ = 0U,
+       .profile_ = 2U,
+       .duration_us_ = 500U,
+       .n_targets_ = 1U,
+       .n_reached_ = 1U},
+      {.start_ = 1U,
+       .profile_ = 1U,
+       .duration_us_ = 900U,
+       .n_targets_ = 1U,
+       .n_reached_ = 1U}};
+  auto const canonical = hash_map<profile_key_t, profile_key_t>{
+      {profile_key_t{1}, profile_key_t{1}},
+      {profile_key_t{2}, profile_key_t{2}},
+      {profile_key_t{3}, profile_key_t{1}}};
+
+  auto const summary = summarize_routing_stats(queries, 1U, canonical);
+
+  ASSERT_EQ(2U, summary.profiles_.size());
+  EXPECT_EQ((std::vector<profile_key_t>{1U, 3U}),
+            summary.profiles_[0].aliases_);
+  EXPECT_EQ((std::vector<profile_key_t>{2U}), summary.profiles_[1].aliases_);
+
+  // without aliases: every profile is its own canonical profile
+  EXPECT_EQ((std::vector<profile_key_t>{1U}),
+            summarize_routing_stats(queries, 1U).profiles_[0].aliases_);
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "transfers/transfer/profiles.h"
+#include "transfers/transfer/transfer_result.h"
+
+#include "routing_fixture.h"
+
+namespace pr = ::ppr::routing;
+
+namespace {
+
+// Returns the results sorted by key and target location.
+std::vector<transfers::transfer_result> normalize(
+    std::vector<transfers::transfer_result> trs) {
+  for (auto& tr : trs) {
+    auto idx = std::vector<std::size_t>(tr.to_locs_.size());
+    for (auto i = std::size_t{0}; i < idx.size(); ++i) {
+      idx[i] = i;
+    }
+    std::sort(begin(idx), end(idx), [&](std::size_t const a, std::size_t b) {
+      return tr.to_locs_[a] < tr.to_locs_[b];
+    });
+
+    auto sorted = tr;
+    for (auto i = std::size_t{0}; i < idx.size(); ++i) {
+      sorted.to_locs_[i] = tr.to_locs_[idx[i]];
+      sorted.infos_[i] = tr.infos_[idx[i]];
+    }
+    tr = sorted;
+  }
+  std::sort(begin(trs), end(trs),
+            [](transfers::transfer_result const& a,
+               transfers::transfer_result const& b) {
+              return a.key() < b.key();
+            });
+  return trs;
+}
+
+}  // namespace
+
+TEST(symmetric_profiles, mirrored_equals_forward) {
+  using namespace transfers;
+
+  auto const f = make_routing_fixture(5U);
+  auto const& pfs = f.pfs_;
+  auto const& locs = f.locs_;
+
+  // all pairs for two profiles
+  auto treqs = std::vector<transfer_request>{};
+  for (auto const prf : {profile_key_t{1}, profile_key_t{2}}) {
+    for (auto const& from : locs) {
+      auto treq = transfer_request{};
+      treq.transfer_start_ = pfs.get_idx(from.key());
+      treq.from_loc_ = from;
+      treq.profile_ = prf;
+      for (auto const& to : locs) {
+        if (to.key() == from.key()) {
+          continue;
+        }
+        treq.transfer_targets_.emplace_back(pfs.get_idx(to.key()));
+        treq.to_locs_.emplace_back(to);
+      }
+      treqs.emplace_back(treq);
+    }
+  }
+
+  auto n_fwd = std::atomic<std::size_t>{0U};
+  auto const fwd = route_multiple_requests(
+      treqs, pfs,
+      [&](pr::routing_query const& rq) { return route_beeline(rq, n_fwd); },
+      f.profiles_);
+
+  auto n_sym = std::atomic<std::size_t>{0U};
+  auto const sym = route_multiple_requests(
+      treqs, pfs,
+      [&](pr::routing_query const& rq) { return route_beeline(rq, n_sym); },
+      f.profiles_, set<profile_key_t>{profile_key_t{1}});
+
+  ASSERT_EQ(normalize(fwd), normalize(sym));
+
+  // profile 1: every pair routed in one direction only (20 -> 10)
+  ASSERT_EQ(n_fwd.load(), 40U);
+  ASSERT_EQ(n_sym.load(), 30U);
+}
+
+TEST(symmetric_profiles, canonical_requires_all_aliases) {
+  using namespace transfers;
+
+  // profiles 1 and 2 are aliases of profile 1, profile 3 is its own
+  auto const canonical = hash_map<profile_key_t, profile_key_t>{
+      {profile_key_t{1}, profile_key_t{1}},
+      {profile_key_t{2}, profile_key_t{1}},
+      {profile_key_t{3}, profile_key_t{3}}};
+
+  auto const only_alias = get_symmetric_canonical_profiles(
+      canonical, set<profile_key_t>{profile_key_t{2}, profile_key_t{3}});
+  ASSERT_EQ(only_alias.size(), 1U);
+  ASSERT_EQ(only_alias.count(profile_key_t{3}), 1U);
+
+  auto const all_aliases = get_symmetric_canonical_profiles(
+      canonical, set<profile_key_t>{profile_key_t{1}, profile_key_t{2}});
+  ASSERT_EQ(all_aliases.size(), 1U);
+  ASSERT_EQ(all_aliases.count(profile_key_t{1}), 1U);
+}
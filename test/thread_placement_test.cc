@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "transfers/transfer/thread_placement.h"
+
+TEST(thread_placement, parse_cpu_list) {
+  using namespace transfers;
+
+  EXPECT_EQ((std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}),
+            parse_cpu_list("0-3,8,10-11\n"));
+  EXPECT_EQ((std::vector<unsigned>{5}), parse_cpu_list("5"));
+  EXPECT_TRUE(parse_cpu_list("").empty());
+}
+
+TEST(thread_placement, node_by_node) {
+  using namespace transfers;
+
+  auto const topology = cpu_topology{{{0, 1, 2, 3}, {4, 5, 6, 7}}};
+
+  auto const capped = make_thread_placement(
+      {.n_threads_ = 3U, .pin_threads_ = true, .numa_aware_ = true}, topology);
+  EXPECT_EQ(3U, capped.n_threads());
+  EXPECT_EQ((std::vector<std::size_t>{0, 0, 0}), capped.nodes_);
+  EXPECT_EQ((std::vector<std::vector<unsigned>>{{0}, {1}, {2}}),
+            capped.cpus_);
+
+  auto const all = make_thread_placement(
+      {.n_threads_ = 0U, .pin_threads_ = false, .numa_aware_ = true},
+      topology);
+  EXPECT_EQ(8U, all.n_threads());
+  EXPECT_EQ((std::vector<std::size_t>{0, 0, 0, 0, 1, 1, 1, 1}), all.nodes_);
+  // not pinned: bound to the CPUs of their node
+  ASSERT_EQ(8U, all.cpus_.size());
+  EXPECT_EQ((std::vector<unsigned>{0, 1, 2, 3}), all.cpus_[3]);
+  EXPECT_EQ((std::vector<unsigned>{4, 5, 6, 7}), all.cpus_[4]);
+
+  auto const pinned = make_thread_placement(
+      {.n_threads_ = 2U, .pin_threads_ = true, .numa_aware_ = false},
+      topology);
+  EXPECT_EQ((std::vector<std::size_t>{0, 0}), pinned.nodes_);
+  EXPECT_EQ((std::vector<std::vector<unsigned>>{{0}, {1}}), pinned.cpus_);
+
+  auto const unplaced = make_thread_placement({}, topology);
+  EXPECT_TRUE(unplaced.nodes_.empty());
+  EXPECT_TRUE(unplaced.cpus_.empty());
+}
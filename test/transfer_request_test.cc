@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "transfers/platform/platform.h"
+#include "transfers/platform/platform_index.h"
+#include "transfers/transfer/transfer_request.h"
+
+#include "geo/latlng.h"
+
+namespace pr = ::ppr::routing;
+
+namespace {
+
+using request_triple =
+    std::tuple<transfers::location_key_t, transfers::profile_key_t,
+               transfers::location_key_t>;
+
+// Returns the (from, profile, to) triples of the given requests.
+std::vector<request_triple> to_triples(
+    transfers::transfer_request_by_keys_csr const& trs) {
+  auto triples = std::vector<request_triple>{};
+  for (auto const treq_k : trs) {
+    for (auto const to_loc : treq_k.to_locs_) {
+      triples.emplace_back(treq_k.from_loc_, treq_k.profile_, to_loc);
+    }
+  }
+  std::sort(begin(triples), end(triples));
+  return triples;
+}
+
+// Reference generator (per profile and state combination, one radius query
+// per location): all pairs of locations whose (different) platforms lie
+// within the max distance of the profile.
+void add_reference_triples(
+    std::vector<request_triple>& triples,
+    std::vector<transfers::platform> const& from_pfs,
+    std::vector<transfers::location> const& from_locs,
+    std::vector<transfers::platform> const& to_pfs,
+    std::vector<transfers::location> const& to_locs,
+    transfers::profile_key_t const prf_key, double const prf_dist) {
+  for (auto i = std::size_t{0}; i < from_pfs.size(); ++i) {
+    for (auto j = std::size_t{0}; j < to_pfs.size(); ++j) {
+      if (from_pfs[i] == to_pfs[j] ||
+          geo::distance(from_pfs[i].loc_, to_pfs[j].loc_) > prf_dist) {
+        continue;
+      }
+      triples.emplace_back(from_locs[i].key(), prf_key, to_locs[j].key());
+    }
+  }
+}
+
+// Appends `n` x `n` platforms on a grid with a spacing of ~25 m; the matched
+// location of every platform lies next to it.
+void make_grid(std::size_t const n, geo::latlng const& origin,
+               std::int64_t const first_osm_id,
+               std::vector<transfers::platform>& pfs,
+               std::vector<transfers::location>& locs) {
+  for (auto i = std::size_t{0}; i < n * n; ++i) {
+    auto pf = transfers::platform{};
+    pf.osm_id_ = first_osm_id + static_cast<std::int64_t>(i);
+    pf.loc_ = {origin.lat_ + static_cast<double>(i / n) * 0.000225 +
+                   static_cast<double>(i % 7U) * 0.00001,
+               origin.lng_ + static_cast<double>(i % n) * 0.00035 +
+                   static_cast<double>(i % 5U) * 0.00001};
+    pfs.emplace_back(pf);
+    locs.emplace_back(geo::latlng{pf.loc_.lat_ + 0.000001, pf.loc_.lng_});
+  }
+}
+
+}  // namespace
+
+TEST(generate_all_pair_transfer_requests_by_keys, equals_reference) {
+  using namespace transfers;
+
+  // old and update state: > 512 platform groups each (several jobs); the
+  // update grid overlaps the old grid
+  auto old_pfs = std::vector<platform>{};
+  auto old_locs = std::vector<location>{};
+  make_grid(24U, {49.8700, 8.6500}, 1, old_pfs, old_locs);
+  auto update_pfs = std::vector<platform>{};
+  auto update_locs = std::vector<location>{};
+  make_grid(24U, {49.8740, 8.6540}, 10'000, update_pfs, update_locs);
+
+  // two locations matched to the same platform (one platform group)
+  old_pfs.emplace_back(old_pfs.front());
+  old_locs.emplace_back(geo::latlng{old_pfs.front().loc_.lat_ - 0.000001,
+                                    old_pfs.front().loc_.lng_});
+
+  auto profiles = hash_map<profile_key_t, pr::search_profile>{};
+  profiles[profile_key_t{1}].walking_speed_ = 1.0;
+  profiles[profile_key_t{1}].duration_limit_ = 40.0;
+  profiles[profile_key_t{2}].walking_speed_ = 1.0;
+  profiles[profile_key_t{2}].duration_limit_ = 70.0;
+  profiles[profile_key_t{3}].walking_speed_ = 0.5;
+  profiles[profile_key_t{3}].duration_limit_ = 220.0;
+
+  auto const old_idx = platform_index{old_pfs};
+  auto const update_idx = platform_index{update_pfs};
+  auto const data = transfer_request_generation_data{
+      .old_ = {old_idx, old_locs, true},
+      .update_ = {update_idx, update_locs, true},
+      .profile_key_to_search_profile_ = profiles};
+
+  auto expected = std::vector<request_triple>{};
+  for (auto const& [prf_key, profile] : profiles) {
+    auto const prf_dist = profile.walking_speed_ * profile.duration_limit_;
+    // 1 -> 1, 1 -> 2, 2 -> 1, 2 -> 2
+    add_reference_triples(expected, old_pfs, old_locs, old_pfs, old_locs,
+                          prf_key, prf_dist);
+    add_reference_triples(expected, old_pfs, old_locs, update_pfs,
+                          update_locs, prf_key, prf_dist);
+    add_reference_triples(expected, update_pfs, update_locs, old_pfs,
+                          old_locs, prf_key, prf_dist);
+    add_reference_triples(expected, update_pfs, update_locs, update_pfs,
+                          update_locs, prf_key, prf_dist);
+  }
+  std::sort(begin(expected), end(expected));
+
+  auto const trs = generate_all_pair_transfer_requests_by_keys(
+      data, {.old_to_old_ = true});
+  auto const actual = to_triples(trs);
+
+  ASSERT_FALSE(expected.empty());
+  ASSERT_EQ(expected.size(), actual.size());
+  ASSERT_EQ(expected, actual);
+
+  // without old to old: all pairs that involve the update state
+  auto const update_only =
+      to_triples(generate_all_pair_transfer_requests_by_keys(
+          data, {.old_to_old_ = false}));
+  auto const old_keys = [&]() {
+    auto keys = set<location_key_t>{};
+    for (auto const& loc : old_locs) {
+      keys.insert(loc.key());
+    }
+    return keys;
+  }();
+  auto expected_update_only = std::vector<request_triple>{};
+  for (auto const& t : expected) {
+    if (old_keys.count(std::get<0>(t)) == 0U ||
+        old_keys.count(std::get<2>(t)) == 0U) {
+      expected_update_only.emplace_back(t);
+    }
+  }
+  ASSERT_EQ(expected_update_only, update_only);
+}